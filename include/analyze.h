@@ -0,0 +1,9 @@
+#ifndef _ANALYZE_H_
+#define _ANALYZE_H_
+
+#include "global.h"
+
+// check semantic errors in the tree and return the number of errors
+int analyze(TreeNode *t);
+
+#endif
\ No newline at end of file
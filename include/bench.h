@@ -0,0 +1,22 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include "global.h"
+
+// time scanning the whole source code reps times with the table-driven
+// scanner and the switch-based one it replaced, and report throughput;
+// with more than one thread also time the parallel lexer
+void bench_lex(int reps, int threads);
+// time both parsers on the whole source code reps times and check that
+// they build the same tree
+void bench_parse(int reps);
+// run a program with the evaluator and with the JIT on the same input,
+// time both and return TRUE if they print the same
+// (the tree must have passed analyze())
+int bench_jit(TreeNode *t, FILE *in);
+// translate a program to C, build it with the C compiler and run it on the
+// same input as the evaluator; time both and return TRUE if they print the
+// same (the tree must have passed analyze())
+int bench_emit(TreeNode *t, FILE *in);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef _BUDGET_H_
+#define _BUDGET_H_
+
+#include <stddef.h>
+
+// limits on the resources used by one parse, 0 means no limit
+typedef struct {
+    // max nesting depth of statements and expressions
+    int max_depth;
+    // max number of tree nodes
+    long max_nodes;
+    // max bytes allocated for the tree
+    long max_bytes;
+    // max characters in a token
+    long max_token_size;
+    // max wall-clock time in milliseconds
+    long max_millis;
+} Budget;
+
+// current limits
+extern Budget budget;
+
+// reset the usage counters and start the clock
+void budget_start(void);
+// give up the parse with a resource error
+void budget_exceeded(char *message, long limit);
+
+// allocate memory for the tree, or return NULL if it's over budget
+void* budget_malloc(size_t size);
+// allocate a tree node, or return NULL if it's over budget
+void* budget_new_node(size_t size);
+
+// enter a nested construct, or return FALSE if it's nested too deep
+int budget_enter(void);
+// leave nested constructs
+void budget_leave(int levels);
+
+// called once per token: check the length and, now and then, the clock
+void budget_check_token(long token_size);
+
+#endif
\ No newline at end of file
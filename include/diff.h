@@ -0,0 +1,17 @@
+#ifndef _DIFF_H_
+#define _DIFF_H_
+
+#include "global.h"
+#include "scanner.h"
+
+// hash every node of a tree bottom-up and return the hash of the top list
+// (parses lazy procedure bodies, so call it before the next set_source)
+uint64_t hash_tree(TreeNode *t);
+
+// print the statements inserted, deleted, moved or modified from old to new
+// (both trees must be hashed, lines tell where their nodes are;
+// equal hashes from hash_tree already mean there's nothing to print)
+void diff_trees(TreeNode *old_tree, const LineTable *old_lines,
+                TreeNode *new_tree, const LineTable *new_lines);
+
+#endif
\ No newline at end of file
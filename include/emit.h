@@ -0,0 +1,9 @@
+#ifndef _EMIT_H_
+#define _EMIT_H_
+
+#include "global.h"
+
+// write a C translation of the program to result file
+void emit_c(TreeNode *t);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef _EVAL_H_
+#define _EVAL_H_
+
+#include "global.h"
+
+// run a program by walking its tree, reading input from in and
+// writing output to out; return FALSE on a runtime error
+int evaluate(TreeNode *t, FILE *in, FILE *out);
+
+#endif
\ No newline at end of file
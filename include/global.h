@@ -2,17 +2,14 @@
 #define _GLOBAL_H_
 
 #include <stdio.h>
+#include <stdint.h>
 
 #define TRUE 1
 #define FALSE 0
 
-// source code file
-extern FILE *src_file;
 // result file
-extern FILE *result_file;
-
-// index of current source code line
-extern int line_idx;
+// (per thread, so threads can print into buffers of their own)
+extern __thread FILE *result_file;
 
 // check if there's any syntax error
 extern int SYNTAX_ERROR;
@@ -101,16 +98,49 @@ typedef enum {
 // max children node for parse tree node
 #define MAX_CHILDREN 3
 
+// range of source code in bytes
+typedef struct {
+    // offset of the first byte
+    long start;
+    // the number of bytes
+    long length;
+} SourceSpan;
+
+// source range of a procedure body that has not been parsed yet
+typedef struct {
+    // offset right after "begin"
+    long start;
+    // offset of the matching "end"
+    long end;
+} LazyBody;
+
+// types a value can have, as a set: MIXED_TYPE is INT_TYPE | FLOAT_TYPE
+typedef enum {
+    // no value, e.g. in code that is never reached
+    NO_TYPE = 0,
+    // always integer
+    INT_TYPE = 1,
+    // always float
+    FLOAT_TYPE = 2,
+    // integer or float, known only at run time
+    MIXED_TYPE = 3
+} ValueType;
+
 typedef struct treeNode {
     struct treeNode* child[MAX_CHILDREN];
     struct treeNode* sibling; // for statements
-    int line_idx;
+    // source code of the node
+    SourceSpan span;
+    // hash of the node and its subtrees, set by hash_tree
+    uint64_t hash;
     NodeType node_type;
     // type of statement or expression
     union {
         StmtType stmt_type;
         ExprType expr_type;
     } type;
+    // type of an expression, set by infer_types
+    ValueType value_type;
     // attribute
     union {
         // for id
@@ -121,6 +151,8 @@ typedef struct treeNode {
         float float_val;
         // for operator
         TokenType op;
+        // for procedure with unparsed body
+        LazyBody *lazy;
     } attr;
 } TreeNode;
 
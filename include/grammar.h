@@ -0,0 +1,93 @@
+#ifndef _GRAMMAR_H_
+#define _GRAMMAR_H_
+
+#include "global.h"
+
+// nonterminals of the LL(1) grammar
+typedef enum {
+    PROGRAM_NT,
+    PROC_DEFS_NT,
+    PROC_DEF_NT,
+    STMTS_NT,
+    STMT_LIST_NT,
+    STMT_NT,
+    ELSE_PART_NT,
+    EXPR_NT,
+    CMP_TAIL_NT,
+    SIMPLE_EXPR_NT,
+    ADD_TAIL_NT,
+    TERM_NT,
+    MUL_TAIL_NT,
+    FACTOR_NT,
+    // the number of nonterminals
+    NT_NUM
+} Nonterminal;
+
+// semantic actions that build the tree while parsing
+typedef enum {
+    // push an empty statement list
+    NEW_LIST_ACTION,
+    // pop a node and append it to the list below it
+    APPEND_ACTION,
+    // enter a nested construct (budget)
+    ENTER_ACTION,
+    // leave a nested construct (budget)
+    LEAVE_ACTION,
+    // push a new procedure node
+    NEW_PROC_ACTION,
+    // push a new statement node, the argument is its StmtType
+    NEW_STMT_ACTION,
+    // push a new expression node with the value of the current token,
+    // the argument is its ExprType
+    NEW_EXPR_ACTION,
+    // name the node on top after the current token, if it's an id
+    NAME_ACTION,
+    // push an id node for a procedure name
+    PROC_NAME_ACTION,
+    // pop a node and make it a child of the node below, the argument is
+    // the child index
+    CHILD_ACTION,
+    // end the span of the node on top at the last matched token
+    FINISH_ACTION,
+    // pop a node and push an operator node with it as left operand
+    OP_ACTION,
+    // remember where "(" starts
+    PAREN_OPEN_ACTION,
+    // pop an expression and the "(" below it, and push the expression
+    // spanning the parentheses
+    PAREN_CLOSE_ACTION,
+    // the number of actions
+    ACTION_NUM
+} Action;
+
+// symbols on the right-hand side of productions:
+// terminals are TokenType values, then come nonterminals and actions
+#define TERMINAL_NUM (ERROR_TOKEN + 1)
+#define NT_BASE TERMINAL_NUM
+#define ACTION_BASE (NT_BASE + NT_NUM)
+// the number of arguments an action may take
+#define ACTION_ARGS 16
+// symbol of a nonterminal
+#define NT(n) (NT_BASE + (n))
+// symbol of an action with an argument
+#define ACT(a, arg) (ACTION_BASE + (a) * ACTION_ARGS + (arg))
+
+// end of a right-hand side
+#define END_RHS -1
+// max symbols on a right-hand side
+#define MAX_RHS 16
+
+// production lhs := rhs
+typedef struct {
+    Nonterminal lhs;
+    short rhs[MAX_RHS];
+} Production;
+
+// productions of the grammar
+extern const Production productions[];
+// the number of productions
+extern const int production_num;
+// names of nonterminals
+extern const char *nonterminal_names[NT_NUM];
+
+#endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef _JIT_H_
+#define _JIT_H_
+
+#include "global.h"
+
+// a program compiled to machine code
+typedef struct JitProgram JitProgram;
+
+// compile a program to x86-64 code, or print why it can't (not an x86-64
+// machine, no executable memory) and return NULL
+// (the tree must have passed analyze(); this also runs infer_types() on it)
+JitProgram* jit_compile(TreeNode *t);
+// run a compiled program, reading input from in and writing output to out;
+// return FALSE on a runtime error
+int jit_execute(JitProgram *program, FILE *in, FILE *out);
+// bytes of machine code in a compiled program
+long jit_code_size(const JitProgram *program);
+// free the code of a compiled program
+void jit_free(JitProgram *program);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,11 @@
+#ifndef _LL1_H_
+#define _LL1_H_
+
+#include "global.h"
+
+// parse and return a new syntax tree with the table-driven LL(1) parser
+// (same tree as the recursive descent parser, with procedure bodies always
+// parsed, but the parse stack is on the heap instead of the C stack)
+TreeNode* ll1_parse(void);
+
+#endif
\ No newline at end of file
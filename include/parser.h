@@ -3,7 +3,20 @@
 
 #include "global.h"
 
+// only find the source range of procedure bodies while parsing,
+// and parse a body when proc_body() first asks for it
+extern int LAZY_PARSE;
+// parse with the table-driven LL(1) parser in ll1.c instead of
+// recursive descent, unless LAZY_PARSE is set
+extern int TABLE_PARSE;
+// lex the source code with this many threads before parsing
+// (1 scans it while parsing)
+extern int LEX_THREADS;
+
 // parse and return a new syntax tree
 TreeNode* parse(void);
+// get the body of a procedure, parsing it first if it was skipped
+// (source code must still be in memory)
+TreeNode* proc_body(TreeNode *t);
 
 #endif
\ No newline at end of file
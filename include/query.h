@@ -0,0 +1,19 @@
+#ifndef _QUERY_H_
+#define _QUERY_H_
+
+#include "global.h"
+
+// inverted indexes of a tree, built once and shared by every query
+typedef struct QueryIndex QueryIndex;
+
+// index the nodes of a tree by kind, by name and by preorder number
+QueryIndex* query_index(TreeNode *t);
+// free memory of the indexes, but not the tree
+void query_free(QueryIndex *index);
+
+// find the nodes matching a path, e.g. "repeat//float" or "assign[fact]",
+// and return how many there are, or -1 if the path is not valid
+// (the results are in source order and valid until the next query)
+int query_find(QueryIndex *index, const char *path, TreeNode ***results);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef _READER_H_
+#define _READER_H_
+
+// a source file loaded in memory
+typedef struct {
+    // name of the file
+    char *filename;
+    // content of the file
+    char *data;
+    // size of the content, -1 if the file can't be read
+    long size;
+    // errno of why the file can't be read, 0 if it was read
+    int error;
+    // allocated size of data, kept when the buffer is reused
+    long capacity;
+} SourceBuffer;
+
+// start reading the files in order in a background thread,
+// keeping at most depth files in memory (if the thread can't start,
+// each file is read by reader_next; returns FALSE if out of memory)
+int reader_start(char **filenames, int file_num, int depth);
+// wait for the next file, or return NULL after the last one
+SourceBuffer* reader_next(void);
+// give a buffer back to the reader once its file is done with
+void reader_release(SourceBuffer *buffer);
+// wait for the reader thread and free the buffers
+void reader_stop(void);
+// seconds spent in reader_next waiting for a file to be read
+double reader_wait_time(void);
+
+// read a whole file into a buffer in the calling thread, growing it if
+// needed (size is -1 and error is set if the file can't be read)
+void read_source(const char *filename, SourceBuffer *buffer);
+
+#endif
\ No newline at end of file
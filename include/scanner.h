@@ -8,8 +8,65 @@
 
 // lexeme of each token, including id and reserved word
 extern char lexeme[MAX_TOKEN_SIZE + 1];
+// source code of the last token, which may be longer than lexeme
+extern SourceSpan token_span;
 
-// get the next token in source file
+// scan source code in memory from the beginning
+// (the data must stay alive while scanning and parsing)
+void set_source(const char *data, long size);
+// get the next token in source code
 TokenType get_next_token(void);
+// get the next token with the switch-based DFA the tables replaced
+// (the same tokens, kept for bench_lex to compare with)
+TokenType get_next_token_switch(void);
+// restart scanning from the beginning of source code
+void reset_scanner(void);
+// offset of the next character to scan in source code
+long scanner_offset(void);
+// continue scanning at an offset of source code
+void scanner_seek(long offset);
+
+// offsets where lines start in source code
+typedef struct {
+    long *starts;
+    int num;
+    int capacity;
+} LineTable;
+
+// lines of the source code being scanned, filled in while scanning
+// (move it out and zero it to keep the lines of a source code)
+extern LineTable line_table;
+
+// line of an offset in a line table, counted from 1
+int table_line(const LineTable *lines, long offset);
+// line of an offset in the scanned source code, counted from 1
+int offset_line(long offset);
+// column of an offset in the scanned source code, counted from 1
+int offset_column(long offset);
+
+// a token of the source code
+typedef struct {
+    TokenType type;
+    SourceSpan span;
+} Token;
+
+// growing array of tokens
+typedef struct {
+    Token *tokens;
+    long num;
+    long capacity;
+} TokenArray;
+
+// lex the whole source code with threads into an array ending with
+// ENDFILE_TOKEN, the same tokens as calling get_next_token until the end
+// (budget checks are left to the caller), and fill in line_table
+void lex_parallel(int thread_num, TokenArray *tokens);
+// read the tokens of source code from an array lexed beforehand instead
+// of scanning it, e.g. by lex_parallel (NULL goes back to scanning from
+// the same offset; the array must stay alive until then)
+void use_token_array(const TokenArray *tokens);
+// copy the lexeme of a token of the source code being scanned
+// (text has room for MAX_TOKEN_SIZE + 1 characters)
+void token_lexeme(const Token *token, char *text);
 
 #endif
\ No newline at end of file
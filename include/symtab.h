@@ -0,0 +1,33 @@
+#ifndef _SYMTAB_H_
+#define _SYMTAB_H_
+
+// symbol in a symbol table
+typedef struct {
+    // name of the symbol, NULL for an empty slot
+    const char *name;
+    // hash of the name
+    unsigned int hash;
+    // value attached by the user of the table
+    int value;
+} Symbol;
+
+// open addressing hash table with linear probing
+typedef struct {
+    Symbol *slots;
+    // always a power of two
+    int capacity;
+    // the number of used slots
+    int size;
+} SymTab;
+
+// initialize an empty table
+void st_init(SymTab *table);
+// free memory of the table, but not the names
+void st_free(SymTab *table);
+// find a symbol, or return NULL if it's not in the table
+Symbol* st_lookup(SymTab *table, const char *name);
+// find a symbol, or add it with value 0 if it's not in the table
+// (the name is not copied and must outlive the table)
+Symbol* st_insert(SymTab *table, const char *name);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef _SYNTAX_H_
+#define _SYNTAX_H_
+
+#include "global.h"
+
+// state and helpers shared by the recursive descent parser and the LL(1)
+// parser, so both report the same errors and give nodes the same spans
+
+// current token
+extern TokenType current_token;
+// offset right after the last matched token
+extern long last_token_end;
+
+// take the current token as matched and scan the next one
+void advance_token(void);
+// report a syntax error at the current token
+void syntax_error(const char *message);
+// report the current token as unexpected
+void unexpected_token(void);
+// end the span of a node at the last matched token
+TreeNode* finish_node(TreeNode *t);
+// create an operator node for the current token with its left operand
+TreeNode* new_op_node(TreeNode *left);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef _TINY_H_
+#define _TINY_H_
+
+#include <stddef.h>
+
+// public interface of libtiny: parse source code held in memory
+// (one parse at a time, the parser keeps its state in globals)
+
+// exported by libtiny.so, which hides the rest of the parser
+#define TINY_API __attribute__((visibility("default")))
+
+// a node of the syntax tree, read with the tiny_node_* functions
+typedef struct treeNode TinyNode;
+
+// a problem found in the source code
+typedef struct {
+    // "Syntax", "Resource" or "Semantic"
+    const char *kind;
+    // byte offset in the source code
+    long offset;
+    // position of the offset, counted from 1
+    int line;
+    int column;
+    // e.g. "Unexpected Token -> ID: x"
+    const char *message;
+} TinyDiagnostic;
+
+// options of a parse, zero for the defaults
+typedef struct {
+    // also check semantic errors
+    int analyze;
+    // parse with the table-driven LL(1) parser
+    int table_parse;
+    // resource limits, 0 for the default of the parser (see README.md),
+    // -1 for no limit
+    int max_depth;
+    long max_nodes;
+    long max_bytes;
+    long max_token_size;
+    long max_millis;
+} TinyOptions;
+
+// the result of a parse
+typedef struct TinyResult TinyResult;
+
+// parse source code of len bytes, options may be NULL
+// (the data isn't needed after the call)
+TINY_API TinyResult* tiny_parse_buffer(const char *data, size_t len, const TinyOptions *options);
+// the syntax tree, or NULL if there's a syntax or resource error
+// (owned by the result)
+TINY_API const TinyNode* tiny_ast(const TinyResult *result);
+// the diagnostics in the order they were found, and how many there are
+TINY_API const TinyDiagnostic* tiny_diagnostics(const TinyResult *result, int *num);
+// line and column of an offset in the source code, counted from 1
+TINY_API void tiny_position(const TinyResult *result, long offset, int *line, int *column);
+// free memory of the result, including its tree
+TINY_API void tiny_destroy(TinyResult *result);
+
+// a child of a node, from index 0 up to 2, or NULL
+// (a procedure has its name and body, an if its test, then and else parts)
+TINY_API const TinyNode* tiny_node_child(const TinyNode *node, int index);
+// the next node in a list of statements or procedures, or NULL
+TINY_API const TinyNode* tiny_node_sibling(const TinyNode *node);
+// write the label of a node, e.g. "Assign to: x", as bin/tiny prints it
+// (80 characters are enough)
+TINY_API void tiny_node_label(const TinyNode *node, char *buffer, size_t size);
+// byte offset and length of the source code of a node
+TINY_API void tiny_node_span(const TinyNode *node, long *start, long *length);
+
+#endif
\ No newline at end of file
@@ -13,9 +13,25 @@ TreeNode* new_expr_node(ExprType expr_type);
 // free memory of the tree
 void free_tree(TreeNode *t);
 
+// longest text of a token, with its terminating null
+#define MAX_TOKEN_TEXT 80
+// write the text of a token, e.g. "ID: x", to a buffer
+void format_token(char *buffer, size_t size, TokenType token_type, const char *lexeme);
 // print a token
 void print_token(TokenType token_type, const char *lexeme);
+// write the label of a node, e.g. "Assign to: x", to a buffer
+// (MAX_TOKEN_TEXT characters are enough)
+void format_node(char *buffer, size_t size, const TreeNode *t);
+// print the label of a node on one line, e.g. "Assign to: x"
+void print_node(TreeNode *t);
+
+// print source spans of nodes or not
+extern int PRINT_SPANS;
+
 // print a tree
 void print_tree(TreeNode *t);
+// print a tree with threads, each formatting a part of the top-level list
+// (the output is the same as print_tree)
+void print_tree_parallel(TreeNode *t, int thread_num);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef _TYPES_H_
+#define _TYPES_H_
+
+#include "global.h"
+
+// set the value_type of each expression in the program to the types its
+// value can have wherever it's evaluated (NO_TYPE if it's never reached),
+// following the types of the variables through the statements
+// (the tree must have passed analyze())
+void infer_types(TreeNode *t);
+// infer the types, then print the type of each variable and how many
+// operations can skip the checks of their operand types
+void print_types(TreeNode *t);
+
+#endif
\ No newline at end of file
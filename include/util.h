@@ -4,4 +4,11 @@
 // copy a string
 char* copy_string(char *src);
 
+// report an error about an offset in source code, printed as e.g.
+// "Syntax error at line 3, column 7: Unexpected Token -> ;"
+void report_error(const char *kind, long offset, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+// called with each error instead of printing it, if set
+extern void (*error_handler)(const char *kind, long offset, const char *message);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,11 @@
+#ifndef _WATCH_H_
+#define _WATCH_H_
+
+// print the AST of every .tny file in a directory, then watch it and print
+// the files again as they change, until interrupted; changes are gathered
+// until the directory is quiet for debounce_millis (0: until the queued
+// events are read), and the AST is printed with threads
+// (returns FALSE if the directory can't be watched or waiting for changes fails)
+int watch_directory(const char *dir, int debounce_millis, int threads);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "analyze.h"
+#include "parser.h"
+#include "symtab.h"
+#include "util.h"
+#include <stdlib.h>
+
+// procedure definition
+typedef struct {
+    TreeNode *node;
+    // body has been checked
+    int visited;
+} ProcInfo;
+
+// procedure name -> 1 + index in procs
+static SymTab proc_table;
+// variable name -> assigned or not
+static SymTab var_table;
+// procedure definitions in order
+static ProcInfo *procs;
+static int proc_num;
+// the number of enclosing repeat statements
+static int loop_depth;
+// the number of semantic errors
+static int error_num;
+
+static void check_stmts(TreeNode *t);
+
+// print semantic error message, with an optional name
+static void print_semantic_error(long offset, char *message, const char *name) {
+    error_num += 1;
+    if (name != NULL) {
+        report_error("Semantic", offset, "%s -> %s", message, name);
+    }
+    else {
+        report_error("Semantic", offset, "%s", message);
+    }
+}
+
+// mark a variable as assigned
+static void assign_var(const char *name) {
+    st_insert(&var_table, name)->value = TRUE;
+}
+
+// check that every variable in the expression has been assigned
+static void check_expr(TreeNode *t) {
+    if (t == NULL) {
+        return;
+    }
+    if (t->type.expr_type == ID_EXPR) {
+        Symbol *s = st_insert(&var_table, t->attr.name);
+        if (!s->value) {
+            print_semantic_error(t->span.start, "Variable used before assignment", t->attr.name);
+            // report each variable only once
+            s->value = TRUE;
+        }
+    }
+    for (int i = 0; i < MAX_CHILDREN; i++) {
+        check_expr(t->child[i]);
+    }
+}
+
+// check the body of a procedure the first time it's called
+static void check_proc(ProcInfo *proc) {
+    if (proc->visited) {
+        return;
+    }
+    proc->visited = TRUE;
+    // a break in the body can't leave a repeat of the caller
+    int saved_loop_depth = loop_depth;
+    loop_depth = 0;
+    check_stmts(proc_body(proc->node));
+    loop_depth = saved_loop_depth;
+}
+
+// check a statement
+static void check_stmt(TreeNode *t) {
+    Symbol *s;
+    switch (t->type.stmt_type) {
+        case READ_STMT:
+            assign_var(t->attr.name);
+            break;
+        case WRITE_STMT:
+            check_expr(t->child[0]);
+            break;
+        case IF_STMT:
+            check_expr(t->child[0]);
+            check_stmts(t->child[1]);
+            check_stmts(t->child[2]);
+            break;
+        case REPEAT_STMT:
+            loop_depth += 1;
+            check_stmts(t->child[0]);
+            loop_depth -= 1;
+            check_expr(t->child[1]);
+            break;
+        case BREAK_STMT:
+            if (loop_depth == 0) {
+                print_semantic_error(t->span.start, "Break outside repeat", NULL);
+            }
+            break;
+        case CONTINUE_STMT:
+            if (loop_depth == 0) {
+                print_semantic_error(t->span.start, "Continue outside repeat", NULL);
+            }
+            break;
+        case ASSIGN_STMT:
+            check_expr(t->child[0]);
+            assign_var(t->attr.name);
+            break;
+        case PROC_CALL_STMT:
+            s = st_lookup(&proc_table, t->attr.name);
+            if (s == NULL) {
+                print_semantic_error(t->span.start, "Undefined procedure", t->attr.name);
+            }
+            else {
+                // walk the body in place of its first call, so variables
+                // it assigns count as assigned after the call
+                check_proc(&procs[s->value - 1]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// check a statement list
+static void check_stmts(TreeNode *t) {
+    for (; t != NULL; t = t->sibling) {
+        check_stmt(t);
+    }
+}
+
+// check semantic errors in the tree and return the number of errors
+// (each node is visited once, so the pass is linear in the tree size)
+int analyze(TreeNode *t) {
+    st_init(&proc_table);
+    st_init(&var_table);
+    error_num = 0;
+    loop_depth = 0;
+
+    // collect procedure definitions
+    int capacity = 16;
+    procs = (ProcInfo *)malloc(capacity * sizeof(ProcInfo));
+    proc_num = 0;
+    for (; t != NULL && t->node_type == PROC_NODE; t = t->sibling) {
+        if (proc_num == capacity) {
+            capacity *= 2;
+            procs = (ProcInfo *)realloc(procs, capacity * sizeof(ProcInfo));
+        }
+        procs[proc_num].node = t;
+        procs[proc_num].visited = FALSE;
+        proc_num += 1;
+        const char *name = t->child[0]->attr.name;
+        Symbol *s = st_insert(&proc_table, name);
+        if (s->value != 0) {
+            print_semantic_error(t->span.start, "Duplicate procedure", name);
+        }
+        else {
+            s->value = proc_num;
+        }
+    }
+
+    // check main program, then procedures that are never called
+    check_stmts(t);
+    for (int i = 0; i < proc_num; i++) {
+        check_proc(&procs[i]);
+    }
+
+    free(procs);
+    st_free(&proc_table);
+    st_free(&var_table);
+    return error_num;
+}
\ No newline at end of file
@@ -0,0 +1,372 @@
+#include "bench.h"
+#include "scanner.h"
+#include "parser.h"
+#include "tree.h"
+#include "diff.h"
+#include "eval.h"
+#include "jit.h"
+#include "emit.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+
+// current time in seconds
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// check that tokens found another way are the ones get_next_token finds
+static int same_tokens(TokenArray *tokens) {
+    reset_scanner();
+    for (long i = 0; i < tokens->num; i++) {
+        TokenType token = get_next_token();
+        if (token != tokens->tokens[i].type || token_span.start != tokens->tokens[i].span.start
+            || token_span.length != tokens->tokens[i].span.length) {
+            return FALSE;
+        }
+    }
+    return tokens->num > 0;
+}
+
+// scan the whole source code into an array with one scanner
+static void collect_tokens(TokenType (*next_token)(void), TokenArray *tokens) {
+    TokenType token;
+    reset_scanner();
+    tokens->num = 0;
+    do {
+        token = next_token();
+        if (tokens->num == tokens->capacity) {
+            tokens->capacity = tokens->capacity ? tokens->capacity * 2 : 4096;
+            tokens->tokens = (Token *)realloc(tokens->tokens, tokens->capacity * sizeof(Token));
+        }
+        tokens->tokens[tokens->num].type = token;
+        tokens->tokens[tokens->num].span = token_span;
+        tokens->num += 1;
+    } while (token != ENDFILE_TOKEN);
+}
+
+// time scanning the whole source code reps times with one scanner, and
+// return the seconds per run
+static double time_lex(int reps, TokenType (*next_token)(void), long *token_num, long *byte_num) {
+    *token_num = 0;
+    *byte_num = 0;
+    double start = now();
+    for (int i = 0; i < reps; i++) {
+        reset_scanner();
+        while (next_token() != ENDFILE_TOKEN) {
+            *token_num += 1;
+        }
+        *byte_num += scanner_offset();
+    }
+    return (now() - start) / reps;
+}
+
+// time scanning the whole source code reps times with the table-driven
+// scanner and the switch-based one it replaced, and report throughput;
+// with more than one thread also time the parallel lexer
+void bench_lex(int reps, int threads) {
+    long token_num = 0;
+    long byte_num = 0;
+    double seconds = time_lex(reps, get_next_token, &token_num, &byte_num);
+    fprintf(result_file, "[========== Lexer Benchmark ==========]\n");
+    fprintf(result_file, "runs: %d\n", reps);
+    fprintf(result_file, "tokens: %ld\n", token_num / reps);
+    fprintf(result_file, "time: %.6f s/run\n", seconds);
+    fprintf(result_file, "throughput: %.2f MB/s, %.2f Mtokens/s\n",
+            byte_num / reps / seconds / 1e6, token_num / reps / seconds / 1e6);
+
+    double switch_seconds = time_lex(reps, get_next_token_switch, &token_num, &byte_num);
+    fprintf(result_file, "switch scanner time: %.6f s/run (tables are %.2fx as fast)\n",
+            switch_seconds, switch_seconds / seconds);
+    TokenArray tokens = { NULL, 0, 0 };
+    collect_tokens(get_next_token_switch, &tokens);
+    fprintf(result_file, "same tokens as the switch scanner: %s\n",
+            same_tokens(&tokens) ? "yes" : "no");
+
+    if (threads > 1) {
+        double start = now();
+        for (int i = 0; i < reps; i++) {
+            lex_parallel(threads, &tokens);
+        }
+        seconds = (now() - start) / reps;
+        fprintf(result_file, "parallel time (%d threads): %.6f s/run\n", threads, seconds);
+        fprintf(result_file, "parallel throughput: %.2f MB/s, %.2f Mtokens/s\n",
+                byte_num / reps / seconds / 1e6, token_num / reps / seconds / 1e6);
+        fprintf(result_file, "same tokens: %s\n", same_tokens(&tokens) ? "yes" : "no");
+    }
+    free(tokens.tokens);
+}
+
+// count the nodes of a tree
+static long count_nodes(TreeNode *t) {
+    long num = 0;
+    for (; t != NULL; t = t->sibling) {
+        num += 1;
+        for (int i = 0; i < MAX_CHILDREN; i++) {
+            num += count_nodes(t->child[i]);
+        }
+    }
+    return num;
+}
+
+// time parsing the whole source code reps times with one parser,
+// and return the hash of the tree, or 0 if there's a syntax error
+static uint64_t time_parse(int reps, int table_parse, const char *name, long *node_num) {
+    TABLE_PARSE = table_parse;
+    uint64_t hash = 0;
+    double start = now();
+    for (int i = 0; i < reps; i++) {
+        reset_scanner();
+        TreeNode *ast = parse();
+        if (SYNTAX_ERROR) {
+            free_tree(ast);
+            return 0;
+        }
+        if (i == 0) {
+            // outside of the first run only the parse is timed
+            double check_start = now();
+            hash = hash_tree(ast);
+            *node_num = count_nodes(ast);
+            start += now() - check_start;
+        }
+        free_tree(ast);
+    }
+    double seconds = now() - start;
+    fprintf(result_file, "%s: %.6f s/run, %.2f Mnodes/s\n", name, seconds / reps,
+            *node_num * reps / seconds / 1e6);
+    return hash;
+}
+
+// time both parsers on the whole source code reps times and check that
+// they build the same tree
+void bench_parse(int reps) {
+    int table_parse = TABLE_PARSE;
+    long node_num = 0;
+    fprintf(result_file, "[========== Parser Benchmark ==========]\n");
+    fprintf(result_file, "runs: %d\n", reps);
+    uint64_t descent_hash = time_parse(reps, FALSE, "recursive descent", &node_num);
+    uint64_t table_hash = descent_hash ? time_parse(reps, TRUE, "table-driven LL(1)", &node_num) : 0;
+    if (descent_hash) {
+        fprintf(result_file, "nodes: %ld\n", node_num);
+        fprintf(result_file, "same tree: %s\n", descent_hash == table_hash ? "yes" : "no");
+    }
+    TABLE_PARSE = table_parse;
+}
+
+// the line an output differs from another in, counted from 1, or 0
+static int first_difference(const char *a, size_t a_size, const char *b, size_t b_size) {
+    int line = 1;
+    for (size_t i = 0; i < a_size || i < b_size; i++) {
+        if (i == a_size || i == b_size || a[i] != b[i]) {
+            return line;
+        }
+        line += a[i] == '\n';
+    }
+    return 0;
+}
+
+// print a line of an output
+static void print_line(const char *name, const char *text, size_t size, int line) {
+    size_t i = 0;
+    for (int l = 1; l < line && i < size; i++) {
+        l += text[i] == '\n';
+    }
+    size_t end = i;
+    while (end < size && text[end] != '\n') {
+        end += 1;
+    }
+    fprintf(result_file, "%s: %.*s\n", name, (int)(end - i), text + i);
+}
+
+// read all of a file into memory
+static char* read_input(FILE *in, size_t *size) {
+    char *input = NULL;
+    FILE *copy = open_memstream(&input, size);
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        fwrite(buffer, 1, n, copy);
+    }
+    fclose(copy);
+    return input;
+}
+
+// run a program with the evaluator and with the JIT on the same input,
+// time both and return TRUE if they print the same
+// (the tree must have passed analyze())
+int bench_jit(TreeNode *t, FILE *in) {
+    // keep the input, both runs read it
+    size_t input_size = 0;
+    char *input = read_input(in, &input_size);
+
+    // run each, with runtime errors in the output
+    char *outputs[2] = { NULL, NULL };
+    size_t sizes[2] = { 0, 0 };
+    double seconds[2] = { 0, 0 };
+    double compile_seconds = 0;
+    long code_size = 0;
+    int supported = TRUE;
+    FILE *saved_file = result_file;
+    for (int i = 0; i < 2 && supported; i++) {
+        FILE *run_in = fmemopen(input, input_size, "r");
+        FILE *run_out = open_memstream(&outputs[i], &sizes[i]);
+        result_file = run_out;
+        double start = now();
+        if (i == 0) {
+            evaluate(t, run_in, run_out);
+        }
+        else {
+            JitProgram *program = jit_compile(t);
+            compile_seconds = now() - start;
+            supported = program != NULL;
+            if (supported) {
+                code_size = jit_code_size(program);
+                jit_execute(program, run_in, run_out);
+                jit_free(program);
+            }
+        }
+        seconds[i] = now() - start;
+        result_file = saved_file;
+        fclose(run_in);
+        fclose(run_out);
+    }
+
+    fprintf(result_file, "[========== JIT Check ==========]\n");
+    int line = first_difference(outputs[0], sizes[0], outputs[1], sizes[1]);
+    if (!supported) {
+        fprintf(result_file, "jit: can't compile here\n");
+    }
+    else {
+        fprintf(result_file, "evaluator: %.6f s\n", seconds[0]);
+        fprintf(result_file, "jit: %.6f s (compile %.6f s, %ld bytes of code)\n",
+                seconds[1], compile_seconds, code_size);
+        fprintf(result_file, "output: %ld bytes\n", (long)sizes[0]);
+        if (line == 0) {
+            fprintf(result_file, "same output: yes\n");
+        }
+        else {
+            fprintf(result_file, "same output: no, first difference at line %d\n", line);
+            print_line("evaluator", outputs[0], sizes[0], line);
+            print_line("jit", outputs[1], sizes[1], line);
+        }
+    }
+    free(input);
+    free(outputs[0]);
+    free(outputs[1]);
+    return supported && line == 0;
+}
+
+// run the evaluator on a program, and return its output with runtime errors
+static char* run_evaluator(TreeNode *t, const char *input, size_t input_size, size_t *size) {
+    char *output = NULL;
+    FILE *run_in = fmemopen((void *)input, input_size, "r");
+    FILE *run_out = open_memstream(&output, size);
+    FILE *saved_file = result_file;
+    result_file = run_out;
+    evaluate(t, run_in, run_out);
+    result_file = saved_file;
+    fclose(run_in);
+    fclose(run_out);
+    return output;
+}
+
+// translate a program to C, build it with the C compiler and run it on the
+// same input as the evaluator; time both and return TRUE if they print the
+// same (the tree must have passed analyze())
+int bench_emit(TreeNode *t, FILE *in) {
+    size_t input_size = 0;
+    char *input = read_input(in, &input_size);
+    double start = now();
+    size_t eval_size = 0;
+    char *eval_output = run_evaluator(t, input, input_size, &eval_size);
+    double eval_seconds = now() - start;
+
+    // write the C code and the input to a temporary directory
+    char dir[] = "/tmp/tiny-emit-XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        fprintf(stderr, "Can't create a temporary directory: %s\n", strerror(errno));
+        free(input);
+        free(eval_output);
+        return FALSE;
+    }
+    char path[PATH_MAX];
+    char command[3 * PATH_MAX];
+    snprintf(path, sizeof(path), "%s/program.c", dir);
+    FILE *saved_file = result_file;
+    result_file = fopen(path, "w");
+    int ok = result_file != NULL;
+    if (ok) {
+        emit_c(t);
+        fclose(result_file);
+    }
+    result_file = saved_file;
+    snprintf(path, sizeof(path), "%s/input", dir);
+    FILE *input_file = fopen(path, "w");
+    if (input_file != NULL) {
+        fwrite(input, 1, input_size, input_file);
+        fclose(input_file);
+    }
+
+    // build it with $CC, or cc
+    const char *cc = getenv("CC") != NULL ? getenv("CC") : "cc";
+    snprintf(command, sizeof(command), "%s -O2 -o %s/program %s/program.c", cc, dir, dir);
+    start = now();
+    ok = ok && input_file != NULL && system(command) == 0;
+    double build_seconds = now() - start;
+
+    // run it, with runtime errors in the output
+    char *c_output = NULL;
+    size_t c_size = 0;
+    double c_seconds = 0;
+    if (ok) {
+        snprintf(command, sizeof(command), "%s/program < %s/input", dir, dir);
+        FILE *copy = open_memstream(&c_output, &c_size);
+        start = now();
+        FILE *run = popen(command, "r");
+        ok = run != NULL;
+        if (ok) {
+            char buffer[4096];
+            size_t n;
+            while ((n = fread(buffer, 1, sizeof(buffer), run)) > 0) {
+                fwrite(buffer, 1, n, copy);
+            }
+            pclose(run);
+        }
+        c_seconds = now() - start;
+        fclose(copy);
+    }
+    snprintf(command, sizeof(command), "rm -rf %s", dir);
+    if (system(command) != 0) {
+        fprintf(stderr, "Can't remove %s\n", dir);
+    }
+
+    fprintf(result_file, "[========== Emit Benchmark ==========]\n");
+    int line = 0;
+    if (!ok) {
+        fprintf(result_file, "the C code could not be built or run with %s\n", cc);
+    }
+    else {
+        line = first_difference(eval_output, eval_size, c_output, c_size);
+        fprintf(result_file, "evaluator: %.6f s\n", eval_seconds);
+        fprintf(result_file, "compiled C: %.6f s (build %.6f s with %s -O2)\n",
+                c_seconds, build_seconds, cc);
+        fprintf(result_file, "speedup: %.2fx\n", eval_seconds / c_seconds);
+        fprintf(result_file, "output: %ld bytes\n", (long)eval_size);
+        if (line == 0) {
+            fprintf(result_file, "same output: yes\n");
+        }
+        else {
+            fprintf(result_file, "same output: no, first difference at line %d\n", line);
+            print_line("evaluator", eval_output, eval_size, line);
+            print_line("compiled C", c_output, c_size, line);
+        }
+    }
+    free(input);
+    free(eval_output);
+    free(c_output);
+    return ok && line == 0;
+}
\ No newline at end of file
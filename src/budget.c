@@ -0,0 +1,101 @@
+#include "budget.h"
+#include "global.h"
+#include "util.h"
+#include "scanner.h"
+#include <stdlib.h>
+#include <time.h>
+
+// current limits
+Budget budget = { 1000, 0, 0, 0, 0 };
+
+// resources used by the current parse
+static int depth;
+static long node_num;
+static long byte_num;
+static long token_num;
+// the time when the parse started
+static struct timespec start_time;
+
+// check the clock once every this many tokens
+#define TIME_CHECK_INTERVAL 1024
+
+// reset the usage counters and start the clock
+void budget_start(void) {
+    depth = 0;
+    node_num = 0;
+    byte_num = 0;
+    token_num = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+// give up the parse with a resource error
+void budget_exceeded(char *message, long limit) {
+    // only report the first error
+    if (!SYNTAX_ERROR) {
+        if (limit > 0) {
+            report_error("Resource", token_span.start, "%s (limit %ld)", message, limit);
+        }
+        else {
+            report_error("Resource", token_span.start, "%s", message);
+        }
+    }
+    // make the parser unwind
+    SYNTAX_ERROR = TRUE;
+}
+
+// allocate memory for the tree, or return NULL if it's over budget
+void* budget_malloc(size_t size) {
+    if (budget.max_bytes > 0 && byte_num + (long)size > budget.max_bytes) {
+        budget_exceeded("Too much memory", budget.max_bytes);
+        return NULL;
+    }
+    void *p = malloc(size);
+    if (p == NULL) {
+        budget_exceeded("Out of memory", 0);
+        return NULL;
+    }
+    byte_num += size;
+    return p;
+}
+
+// allocate a tree node, or return NULL if it's over budget
+void* budget_new_node(size_t size) {
+    if (budget.max_nodes > 0 && node_num >= budget.max_nodes) {
+        budget_exceeded("Too many nodes", budget.max_nodes);
+        return NULL;
+    }
+    node_num += 1;
+    return budget_malloc(size);
+}
+
+// enter a nested construct, or return FALSE if it's nested too deep
+int budget_enter(void) {
+    if (budget.max_depth > 0 && depth >= budget.max_depth) {
+        budget_exceeded("Nesting too deep", budget.max_depth);
+        return FALSE;
+    }
+    depth += 1;
+    return TRUE;
+}
+
+// leave nested constructs
+void budget_leave(int levels) {
+    depth -= levels;
+}
+
+// called once per token: check the length and, now and then, the clock
+void budget_check_token(long token_size) {
+    if (budget.max_token_size > 0 && token_size > budget.max_token_size) {
+        budget_exceeded("Token too long", budget.max_token_size);
+    }
+    token_num += 1;
+    if (budget.max_millis > 0 && token_num % TIME_CHECK_INTERVAL == 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long millis = (now.tv_sec - start_time.tv_sec) * 1000
+                      + (now.tv_nsec - start_time.tv_nsec) / 1000000;
+        if (millis > budget.max_millis) {
+            budget_exceeded("Time limit exceeded", budget.max_millis);
+        }
+    }
+}
\ No newline at end of file
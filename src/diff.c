@@ -0,0 +1,365 @@
+#include "diff.h"
+#include "parser.h"
+#include "tree.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 64-bit FNV-1a parameters
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// fold a value into a hash
+static uint64_t mix(uint64_t h, uint64_t x) {
+    h = (h ^ x) * FNV_PRIME;
+    return h ^ (h >> 32);
+}
+
+// FNV-1a hash of a name
+static uint64_t hash_name(const char *name) {
+    uint64_t h = FNV_OFFSET;
+    if (name != NULL) {
+        for (const char *c = name; *c != '\0'; c++) {
+            h = (h ^ (unsigned char)*c) * FNV_PRIME;
+        }
+    }
+    return h;
+}
+
+// name of a named node, or NULL
+static const char* node_name(TreeNode *t) {
+    if (t->node_type == PROC_NODE) {
+        return t->child[0] != NULL ? t->child[0]->attr.name : NULL;
+    }
+    else if (t->node_type == STMT_NODE) {
+        if (t->type.stmt_type == READ_STMT || t->type.stmt_type == ASSIGN_STMT
+            || t->type.stmt_type == PROC_CALL_STMT) {
+            return t->attr.name;
+        }
+    }
+    else if (t->node_type == EXPR_NODE && t->type.expr_type == ID_EXPR) {
+        return t->attr.name;
+    }
+    return NULL;
+}
+
+// hash of the kind of a node and its name, if any
+// (nodes with the same key are the same statement, maybe modified)
+static uint64_t node_key(TreeNode *t) {
+    uint64_t h = mix(FNV_OFFSET, t->node_type);
+    if (t->node_type == STMT_NODE) {
+        h = mix(h, t->type.stmt_type);
+    }
+    else if (t->node_type == EXPR_NODE) {
+        h = mix(h, t->type.expr_type);
+    }
+    const char *name = node_name(t);
+    if (name != NULL) {
+        h = mix(h, hash_name(name));
+    }
+    return h;
+}
+
+static uint64_t hash_list(TreeNode *t);
+
+// hash a node from its key, its value and the hashes of its children
+static void hash_node(TreeNode *t) {
+    if (t->node_type == PROC_NODE && t->attr.lazy != NULL) {
+        proc_body(t);
+    }
+    uint64_t h = node_key(t);
+    if (t->node_type == EXPR_NODE) {
+        if (t->type.expr_type == INTEGER_EXPR) {
+            h = mix(h, (uint32_t)t->attr.integer_val);
+        }
+        else if (t->type.expr_type == FLOAT_EXPR) {
+            uint32_t bits;
+            memcpy(&bits, &t->attr.float_val, sizeof(bits));
+            h = mix(h, bits);
+        }
+        else if (t->type.expr_type == OP_EXPR) {
+            h = mix(h, t->attr.op);
+        }
+    }
+    for (int i = 0; i < MAX_CHILDREN; i++) {
+        h = mix(h, hash_list(t->child[i]));
+    }
+    t->hash = h;
+}
+
+// hash every node of a list and return the hash of the list
+// (loops over siblings, so only nesting uses the stack)
+static uint64_t hash_list(TreeNode *t) {
+    uint64_t h = FNV_OFFSET;
+    while (t != NULL) {
+        hash_node(t);
+        h = mix(h, t->hash);
+        t = t->sibling;
+    }
+    return h;
+}
+
+// hash every node of a tree bottom-up and return the hash of the top list
+uint64_t hash_tree(TreeNode *t) {
+    return hash_list(t);
+}
+
+// a statement list as an array
+typedef struct {
+    TreeNode **nodes;
+    int num;
+} NodeList;
+
+// put the nodes of a list into an array
+static NodeList to_array(TreeNode *t) {
+    NodeList list = { NULL, 0 };
+    for (TreeNode *p = t; p != NULL; p = p->sibling) {
+        list.num += 1;
+    }
+    list.nodes = (TreeNode **)malloc((list.num + 1) * sizeof(TreeNode *));
+    for (int i = 0; t != NULL; t = t->sibling) {
+        list.nodes[i++] = t;
+    }
+    return list;
+}
+
+// a node of the old list in an index
+typedef struct {
+    uint64_t key;
+    // position in the old list
+    int position;
+    // the number of nodes taken from the group, kept in its first entry
+    int taken;
+} IndexEntry;
+
+// old nodes sorted by key, so each new node finds its partner in O(log n)
+typedef struct {
+    IndexEntry *entries;
+    int num;
+} Index;
+
+// order index entries by key, then by position
+static int compare_entries(const void *a, const void *b) {
+    const IndexEntry *x = (const IndexEntry *)a;
+    const IndexEntry *y = (const IndexEntry *)b;
+    if (x->key != y->key) {
+        return x->key < y->key ? -1 : 1;
+    }
+    return x->position - y->position;
+}
+
+// take the first old node with the key that is not taken yet, or return -1
+static int index_take(Index *index, uint64_t key) {
+    // find the first entry with the key
+    int low = 0;
+    int high = index->num;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (index->entries[mid].key < key) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    if (low == index->num || index->entries[low].key != key) {
+        return -1;
+    }
+    IndexEntry *group = &index->entries[low];
+    int i = low + group->taken;
+    if (i == index->num || index->entries[i].key != key) {
+        return -1;
+    }
+    group->taken += 1;
+    return index->entries[i].position;
+}
+
+// lines of the trees being compared
+static const LineTable *old_lines;
+static const LineTable *new_lines;
+// nesting of the statements being compared
+static int diff_depth = 0;
+// the number of changes printed
+static int change_num = 0;
+
+// print one change, old or new may be NULL
+static void print_change(const char *what, TreeNode *old_node, TreeNode *new_node) {
+    for (int i = 0; i < diff_depth; i++) {
+        fprintf(result_file, "    ");
+    }
+    fprintf(result_file, "%s (line ", what);
+    if (old_node != NULL) {
+        fprintf(result_file, "%d", table_line(old_lines, old_node->span.start));
+    }
+    if (old_node != NULL && new_node != NULL) {
+        fprintf(result_file, " -> ");
+    }
+    if (new_node != NULL) {
+        fprintf(result_file, "%d", table_line(new_lines, new_node->span.start));
+    }
+    fprintf(result_file, "): ");
+    TreeNode *t = new_node != NULL ? new_node : old_node;
+    if (t->node_type == PROC_NODE) {
+        fprintf(result_file, "Function Definition: %s\n", node_name(t));
+    }
+    else {
+        print_node(t);
+    }
+    change_num += 1;
+}
+
+// mark the matched pairs that keep their order, i.e. a longest increasing
+// subsequence of old positions; the others have moved
+static void find_unmoved(const int *old_pos, const int *modified, int num, int *unmoved) {
+    // tails[k]: new index of the smallest tail of increasing runs of length k + 1
+    int *tails = (int *)malloc((num + 1) * sizeof(int));
+    int *prev = (int *)malloc((num + 1) * sizeof(int));
+    int length = 0;
+    for (int j = 0; j < num; j++) {
+        unmoved[j] = FALSE;
+        if (old_pos[j] < 0 || modified[j]) {
+            continue;
+        }
+        int low = 0;
+        int high = length;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (old_pos[tails[mid]] < old_pos[j]) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        prev[j] = low > 0 ? tails[low - 1] : -1;
+        tails[low] = j;
+        if (low == length) {
+            length += 1;
+        }
+    }
+    for (int j = length > 0 ? tails[length - 1] : -1; j >= 0; j = prev[j]) {
+        unmoved[j] = TRUE;
+    }
+    free(tails);
+    free(prev);
+}
+
+static void diff_list(TreeNode *old_list, TreeNode *new_list);
+
+// compare the statement lists inside two versions of a statement
+static void diff_children(TreeNode *old_node, TreeNode *new_node) {
+    diff_depth += 1;
+    if (new_node->node_type == PROC_NODE) {
+        diff_list(old_node->child[1], new_node->child[1]);
+    }
+    else if (new_node->node_type == STMT_NODE) {
+        if (new_node->type.stmt_type == IF_STMT) {
+            diff_list(old_node->child[1], new_node->child[1]);
+            diff_list(old_node->child[2], new_node->child[2]);
+        }
+        else if (new_node->type.stmt_type == REPEAT_STMT) {
+            diff_list(old_node->child[0], new_node->child[0]);
+        }
+    }
+    diff_depth -= 1;
+}
+
+// print the changes from one statement list to another
+static void diff_list(TreeNode *old_list, TreeNode *new_list) {
+    NodeList a = to_array(old_list);
+    NodeList b = to_array(new_list);
+    // skip the equal head and tail, only the middle has changed
+    int head = 0;
+    while (head < a.num && head < b.num && a.nodes[head]->hash == b.nodes[head]->hash) {
+        head += 1;
+    }
+    int a_end = a.num;
+    int b_end = b.num;
+    while (a_end > head && b_end > head
+           && a.nodes[a_end - 1]->hash == b.nodes[b_end - 1]->hash) {
+        a_end -= 1;
+        b_end -= 1;
+    }
+    TreeNode **old_nodes = a.nodes + head;
+    TreeNode **new_nodes = b.nodes + head;
+    int old_num = a_end - head;
+    int new_num = b_end - head;
+
+    // old position of each new node, or -1 if it's inserted
+    int *old_pos = (int *)malloc((new_num + 1) * sizeof(int));
+    int *modified = (int *)calloc(new_num + 1, sizeof(int));
+    int *unmoved = (int *)malloc((new_num + 1) * sizeof(int));
+    int *taken = (int *)calloc(old_num + 1, sizeof(int));
+    Index index;
+    index.entries = (IndexEntry *)malloc((old_num + 1) * sizeof(IndexEntry));
+
+    // pair equal subtrees by hash
+    index.num = 0;
+    for (int i = 0; i < old_num; i++) {
+        index.entries[index.num++] = (IndexEntry){ old_nodes[i]->hash, i, 0 };
+    }
+    qsort(index.entries, index.num, sizeof(IndexEntry), compare_entries);
+    for (int j = 0; j < new_num; j++) {
+        old_pos[j] = index_take(&index, new_nodes[j]->hash);
+        if (old_pos[j] >= 0) {
+            taken[old_pos[j]] = TRUE;
+        }
+    }
+    find_unmoved(old_pos, modified, new_num, unmoved);
+
+    // pair the rest by kind and name, these are modified
+    index.num = 0;
+    for (int i = 0; i < old_num; i++) {
+        if (!taken[i]) {
+            index.entries[index.num++] = (IndexEntry){ node_key(old_nodes[i]), i, 0 };
+        }
+    }
+    qsort(index.entries, index.num, sizeof(IndexEntry), compare_entries);
+    for (int j = 0; j < new_num; j++) {
+        if (old_pos[j] < 0) {
+            old_pos[j] = index_take(&index, node_key(new_nodes[j]));
+            if (old_pos[j] >= 0) {
+                taken[old_pos[j]] = TRUE;
+                modified[j] = TRUE;
+            }
+        }
+    }
+
+    // print deleted statements in old order, then the others in new order
+    for (int i = 0; i < old_num; i++) {
+        if (!taken[i]) {
+            print_change("Deleted", old_nodes[i], NULL);
+        }
+    }
+    for (int j = 0; j < new_num; j++) {
+        if (old_pos[j] < 0) {
+            print_change("Inserted", NULL, new_nodes[j]);
+        }
+        else if (modified[j]) {
+            print_change("Modified", old_nodes[old_pos[j]], new_nodes[j]);
+            diff_children(old_nodes[old_pos[j]], new_nodes[j]);
+        }
+        else if (!unmoved[j]) {
+            print_change("Moved", old_nodes[old_pos[j]], new_nodes[j]);
+        }
+    }
+
+    free(index.entries);
+    free(taken);
+    free(unmoved);
+    free(modified);
+    free(old_pos);
+    free(a.nodes);
+    free(b.nodes);
+}
+
+// print the statements inserted, deleted, moved or modified from old to new
+void diff_trees(TreeNode *old_tree, const LineTable *old_table,
+                TreeNode *new_tree, const LineTable *new_table) {
+    old_lines = old_table;
+    new_lines = new_table;
+    change_num = 0;
+    diff_list(old_tree, new_tree);
+    if (change_num == 0) {
+        fprintf(result_file, "No changes\n");
+    }
+}
\ No newline at end of file
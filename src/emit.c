@@ -0,0 +1,239 @@
+#include "emit.h"
+#include "parser.h"
+#include "scanner.h"
+#include "symtab.h"
+#include <stdlib.h>
+#include <math.h>
+
+// runtime of the generated code, with the same semantics as eval.c
+static const char *runtime =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <limits.h>\n"
+    "#include <math.h>\n"
+    "\n"
+    "typedef struct { int is_float; int i; double f; } Value;\n"
+    "\n"
+    "static void tiny_error(int line, int column, const char *message) {\n"
+    "    fflush(stdout);\n"
+    "    printf(\"Runtime error at line %d, column %d: %s\\n\", line, column, message);\n"
+    "    exit(EXIT_FAILURE);\n"
+    "}\n"
+    "static inline Value tiny_int(int i) { Value v = { 0, i, 0 }; return v; }\n"
+    "static inline Value tiny_float(double f) { Value v = { 1, 0, f }; return v; }\n"
+    "static inline double tiny_to_float(Value v) { return v.is_float ? v.f : v.i; }\n"
+    "static inline int tiny_true(Value v) { return v.is_float ? v.f != 0 : v.i != 0; }\n"
+    "static inline Value tiny_add(Value a, Value b) {\n"
+    "    if (a.is_float || b.is_float) return tiny_float(tiny_to_float(a) + tiny_to_float(b));\n"
+    "    return tiny_int((int)((unsigned int)a.i + (unsigned int)b.i));\n"
+    "}\n"
+    "static inline Value tiny_sub(Value a, Value b) {\n"
+    "    if (a.is_float || b.is_float) return tiny_float(tiny_to_float(a) - tiny_to_float(b));\n"
+    "    return tiny_int((int)((unsigned int)a.i - (unsigned int)b.i));\n"
+    "}\n"
+    "static inline Value tiny_mul(Value a, Value b) {\n"
+    "    if (a.is_float || b.is_float) return tiny_float(tiny_to_float(a) * tiny_to_float(b));\n"
+    "    return tiny_int((int)((unsigned int)a.i * (unsigned int)b.i));\n"
+    "}\n"
+    "static inline Value tiny_div(Value a, Value b, int line, int column) {\n"
+    "    if (a.is_float || b.is_float) return tiny_float(tiny_to_float(a) / tiny_to_float(b));\n"
+    "    if (b.i == 0) tiny_error(line, column, \"Division by zero\");\n"
+    "    return tiny_int((a.i == INT_MIN && b.i == -1) ? INT_MIN : a.i / b.i);\n"
+    "}\n"
+    "static inline Value tiny_lt(Value a, Value b) {\n"
+    "    if (a.is_float || b.is_float) return tiny_int(tiny_to_float(a) < tiny_to_float(b));\n"
+    "    return tiny_int(a.i < b.i);\n"
+    "}\n"
+    "static inline Value tiny_eq(Value a, Value b) {\n"
+    "    if (a.is_float || b.is_float) return tiny_int(tiny_to_float(a) == tiny_to_float(b));\n"
+    "    return tiny_int(a.i == b.i);\n"
+    "}\n"
+    "static void tiny_read(Value *v, int line, int column) {\n"
+    "    char buf[64], *end, *p;\n"
+    "    int is_float = 0;\n"
+    "    if (scanf(\"%63s\", buf) != 1) tiny_error(line, column, \"Missing input\");\n"
+    "    for (p = buf; *p != '\\0'; p++) is_float |= (*p == '.');\n"
+    "    if (is_float) *v = tiny_float(strtod(buf, &end));\n"
+    "    else *v = tiny_int((int)strtol(buf, &end, 10));\n"
+    "    if (*end != '\\0') tiny_error(line, column, \"Input is not a number\");\n"
+    "}\n"
+    "static void tiny_write(Value v) {\n"
+    "    if (v.is_float) printf(\"%g\\n\", v.f);\n"
+    "    else printf(\"%d\\n\", v.i);\n"
+    "}\n";
+
+// indentation of generated code
+static int indent;
+
+// variables declared so far
+static SymTab var_table;
+
+// print spaces to indent
+static void emit_indent(void) {
+    for (int i = 0; i < indent; i++) {
+        fprintf(result_file, "    ");
+    }
+}
+
+// declare every variable in the tree
+static void declare_vars(TreeNode *t) {
+    for (; t != NULL; t = t->sibling) {
+        const char *name = NULL;
+        if (t->node_type == STMT_NODE && (t->type.stmt_type == READ_STMT
+                                          || t->type.stmt_type == ASSIGN_STMT)) {
+            name = t->attr.name;
+        }
+        else if (t->node_type == EXPR_NODE && t->type.expr_type == ID_EXPR) {
+            name = t->attr.name;
+        }
+        if (name != NULL) {
+            Symbol *s = st_insert(&var_table, name);
+            if (!s->value) {
+                s->value = TRUE;
+                fprintf(result_file, "static Value v_%s;\n", name);
+            }
+        }
+        if (t->node_type == PROC_NODE) {
+            // child[0] is the procedure name
+            declare_vars(proc_body(t));
+            continue;
+        }
+        for (int i = 0; i < MAX_CHILDREN; i++) {
+            declare_vars(t->child[i]);
+        }
+    }
+}
+
+// write an expression
+static void emit_expr(TreeNode *t) {
+    switch (t->type.expr_type) {
+        case ID_EXPR:
+            fprintf(result_file, "v_%s", t->attr.name);
+            return;
+        case INTEGER_EXPR:
+            fprintf(result_file, "tiny_int(%d)", t->attr.integer_val);
+            return;
+        case FLOAT_EXPR:
+            // exact decimal form of the float, or HUGE_VAL for a literal
+            // too large for one (%g would print inf, which isn't C)
+            if (isinf(t->attr.float_val)) {
+                fprintf(result_file, "tiny_float(HUGE_VAL)");
+            }
+            else {
+                fprintf(result_file, "tiny_float(%.17g)", (double)t->attr.float_val);
+            }
+            return;
+        default:
+            break;
+    }
+    switch (t->attr.op) {
+        case ADD_TOKEN: fprintf(result_file, "tiny_add("); break;
+        case SUB_TOKEN: fprintf(result_file, "tiny_sub("); break;
+        case MUL_TOKEN: fprintf(result_file, "tiny_mul("); break;
+        case DIV_TOKEN: fprintf(result_file, "tiny_div("); break;
+        case LT_TOKEN: fprintf(result_file, "tiny_lt("); break;
+        default: fprintf(result_file, "tiny_eq("); break;
+    }
+    emit_expr(t->child[0]);
+    fprintf(result_file, ", ");
+    emit_expr(t->child[1]);
+    if (t->attr.op == DIV_TOKEN) {
+        fprintf(result_file, ", %d, %d", offset_line(t->span.start), offset_column(t->span.start));
+    }
+    fprintf(result_file, ")");
+}
+
+static void emit_stmts(TreeNode *t);
+
+// write a statement
+static void emit_stmt(TreeNode *t) {
+    emit_indent();
+    switch (t->type.stmt_type) {
+        case READ_STMT:
+            fprintf(result_file, "tiny_read(&v_%s, %d, %d);\n", t->attr.name,
+                    offset_line(t->span.start), offset_column(t->span.start));
+            break;
+        case WRITE_STMT:
+            fprintf(result_file, "tiny_write(");
+            emit_expr(t->child[0]);
+            fprintf(result_file, ");\n");
+            break;
+        case IF_STMT:
+            fprintf(result_file, "if (tiny_true(");
+            emit_expr(t->child[0]);
+            fprintf(result_file, ")) {\n");
+            emit_stmts(t->child[1]);
+            if (t->child[2] != NULL) {
+                emit_indent();
+                fprintf(result_file, "}\n");
+                emit_indent();
+                fprintf(result_file, "else {\n");
+                emit_stmts(t->child[2]);
+            }
+            emit_indent();
+            fprintf(result_file, "}\n");
+            break;
+        case REPEAT_STMT:
+            // continue in a do-while goes on to the condition, as in Tiny
+            fprintf(result_file, "do {\n");
+            emit_stmts(t->child[0]);
+            emit_indent();
+            fprintf(result_file, "} while (!tiny_true(");
+            emit_expr(t->child[1]);
+            fprintf(result_file, "));\n");
+            break;
+        case BREAK_STMT:
+            fprintf(result_file, "break;\n");
+            break;
+        case CONTINUE_STMT:
+            fprintf(result_file, "continue;\n");
+            break;
+        case ASSIGN_STMT:
+            fprintf(result_file, "v_%s = ", t->attr.name);
+            emit_expr(t->child[0]);
+            fprintf(result_file, ";\n");
+            break;
+        case PROC_CALL_STMT:
+            fprintf(result_file, "p_%s();\n", t->attr.name);
+            break;
+        default:
+            break;
+    }
+}
+
+// write a statement list
+static void emit_stmts(TreeNode *t) {
+    indent += 1;
+    for (; t != NULL; t = t->sibling) {
+        emit_stmt(t);
+    }
+    indent -= 1;
+}
+
+// write a C translation of the program to result file
+// (the tree must have passed analyze())
+void emit_c(TreeNode *t) {
+    fprintf(result_file, "/* generated by tiny */\n");
+    fprintf(result_file, "%s\n", runtime);
+
+    // globals
+    st_init(&var_table);
+    declare_vars(t);
+    st_free(&var_table);
+    fprintf(result_file, "\n");
+
+    // procedures
+    for (TreeNode *p = t; p != NULL && p->node_type == PROC_NODE; p = p->sibling) {
+        fprintf(result_file, "static void p_%s(void);\n", p->child[0]->attr.name);
+    }
+    for (; t != NULL && t->node_type == PROC_NODE; t = t->sibling) {
+        fprintf(result_file, "\nstatic void p_%s(void) {\n", t->child[0]->attr.name);
+        emit_stmts(proc_body(t));
+        fprintf(result_file, "}\n");
+    }
+
+    // main program
+    fprintf(result_file, "\nint main(void) {\n");
+    emit_stmts(t);
+    fprintf(result_file, "    return 0;\n}\n");
+}
\ No newline at end of file
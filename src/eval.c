@@ -0,0 +1,261 @@
+#include "eval.h"
+#include "parser.h"
+#include "symtab.h"
+#include "util.h"
+#include <stdlib.h>
+#include <limits.h>
+#include <setjmp.h>
+
+// value of a variable or an expression
+typedef struct {
+    int is_float;
+    int i;
+    double f;
+} Value;
+
+// how a statement list finished
+typedef enum {
+    NORMAL_EXIT,
+    BREAK_EXIT,
+    CONTINUE_EXIT
+} ExitType;
+
+// procedure name -> procedure node
+static SymTab proc_table;
+static TreeNode **procs;
+// variable name -> 1 + index in vars
+static SymTab var_table;
+static Value *vars;
+static int var_num;
+static int var_capacity;
+
+static FILE *input;
+static FILE *output;
+// where to go on a runtime error
+static jmp_buf error_exit;
+
+static ExitType exec_stmts(TreeNode *t);
+
+// print runtime error message and stop the program
+static void runtime_error(long offset, char *message) {
+    report_error("Runtime", offset, "%s", message);
+    longjmp(error_exit, 1);
+}
+
+// find the value of a variable, creating it as integer 0
+static Value* lookup_var(const char *name) {
+    Symbol *s = st_insert(&var_table, name);
+    if (s->value == 0) {
+        if (var_num == var_capacity) {
+            var_capacity = var_capacity ? var_capacity * 2 : 64;
+            vars = (Value *)realloc(vars, var_capacity * sizeof(Value));
+        }
+        vars[var_num] = (Value){ FALSE, 0, 0 };
+        var_num += 1;
+        s->value = var_num;
+    }
+    return &vars[s->value - 1];
+}
+
+// convert a value to float
+static double to_float(Value v) {
+    return v.is_float ? v.f : v.i;
+}
+
+// check if a value is true
+static int is_true(Value v) {
+    return v.is_float ? v.f != 0 : v.i != 0;
+}
+
+// evaluate an expression
+static Value eval_expr(TreeNode *t) {
+    Value v = { FALSE, 0, 0 };
+    switch (t->type.expr_type) {
+        case ID_EXPR:
+            return *lookup_var(t->attr.name);
+        case INTEGER_EXPR:
+            v.i = t->attr.integer_val;
+            return v;
+        case FLOAT_EXPR:
+            v.is_float = TRUE;
+            v.f = t->attr.float_val;
+            return v;
+        default:
+            break;
+    }
+    Value a = eval_expr(t->child[0]);
+    Value b = eval_expr(t->child[1]);
+    if (t->attr.op == LT_TOKEN || t->attr.op == EQ_TOKEN) {
+        // comparisons give integer 1 or 0
+        if (a.is_float || b.is_float) {
+            double x = to_float(a), y = to_float(b);
+            v.i = (t->attr.op == LT_TOKEN) ? x < y : x == y;
+        }
+        else {
+            v.i = (t->attr.op == LT_TOKEN) ? a.i < b.i : a.i == b.i;
+        }
+    }
+    else if (a.is_float || b.is_float) {
+        // float arithmetic if either side is float
+        double x = to_float(a), y = to_float(b);
+        v.is_float = TRUE;
+        switch (t->attr.op) {
+            case ADD_TOKEN: v.f = x + y; break;
+            case SUB_TOKEN: v.f = x - y; break;
+            case MUL_TOKEN: v.f = x * y; break;
+            default: v.f = x / y; break;
+        }
+    }
+    else {
+        // integer arithmetic wraps around
+        unsigned int x = a.i, y = b.i;
+        switch (t->attr.op) {
+            case ADD_TOKEN: v.i = (int)(x + y); break;
+            case SUB_TOKEN: v.i = (int)(x - y); break;
+            case MUL_TOKEN: v.i = (int)(x * y); break;
+            default:
+                if (b.i == 0) {
+                    runtime_error(t->span.start, "Division by zero");
+                }
+                v.i = (a.i == INT_MIN && b.i == -1) ? INT_MIN : a.i / b.i;
+                break;
+        }
+    }
+    return v;
+}
+
+// read a number: float if it has a '.', integer otherwise
+static void read_value(Value *v, long offset) {
+    char buf[64];
+    char *end;
+    if (fscanf(input, "%63s", buf) != 1) {
+        runtime_error(offset, "Missing input");
+    }
+    int is_float = FALSE;
+    for (char *p = buf; *p != '\0'; p++) {
+        is_float |= (*p == '.');
+    }
+    if (is_float) {
+        v->is_float = TRUE;
+        v->f = strtod(buf, &end);
+    }
+    else {
+        v->is_float = FALSE;
+        v->i = (int)strtol(buf, &end, 10);
+    }
+    if (*end != '\0') {
+        runtime_error(offset, "Input is not a number");
+    }
+}
+
+// write a value on its own line
+static void write_value(Value v) {
+    if (v.is_float) {
+        fprintf(output, "%g\n", v.f);
+    }
+    else {
+        fprintf(output, "%d\n", v.i);
+    }
+}
+
+// execute a statement
+static ExitType exec_stmt(TreeNode *t) {
+    ExitType exit_type;
+    switch (t->type.stmt_type) {
+        case READ_STMT:
+            read_value(lookup_var(t->attr.name), t->span.start);
+            break;
+        case WRITE_STMT:
+            write_value(eval_expr(t->child[0]));
+            break;
+        case IF_STMT:
+            if (is_true(eval_expr(t->child[0]))) {
+                return exec_stmts(t->child[1]);
+            }
+            return exec_stmts(t->child[2]);
+        case REPEAT_STMT:
+            // continue goes on to the condition, like in a C do-while
+            do {
+                exit_type = exec_stmts(t->child[0]);
+                if (exit_type == BREAK_EXIT) {
+                    break;
+                }
+            } while (!is_true(eval_expr(t->child[1])));
+            break;
+        case BREAK_STMT:
+            return BREAK_EXIT;
+        case CONTINUE_STMT:
+            return CONTINUE_EXIT;
+        case ASSIGN_STMT: {
+            Value v = eval_expr(t->child[0]);
+            *lookup_var(t->attr.name) = v;
+            break;
+        }
+        case PROC_CALL_STMT: {
+            Symbol *s = st_lookup(&proc_table, t->attr.name);
+            if (s == NULL) {
+                runtime_error(t->span.start, "Undefined procedure");
+            }
+            exec_stmts(proc_body(procs[s->value - 1]));
+            break;
+        }
+        default:
+            break;
+    }
+    return NORMAL_EXIT;
+}
+
+// execute a statement list until it ends, breaks or continues
+static ExitType exec_stmts(TreeNode *t) {
+    for (; t != NULL; t = t->sibling) {
+        ExitType exit_type = exec_stmt(t);
+        if (exit_type != NORMAL_EXIT) {
+            return exit_type;
+        }
+    }
+    return NORMAL_EXIT;
+}
+
+// run the main program, or return FALSE when a runtime error jumps out
+// (nothing is changed after setjmp, so longjmp can't clobber it)
+static int run_main(TreeNode *t) {
+    if (setjmp(error_exit) != 0) {
+        return FALSE;
+    }
+    exec_stmts(t);
+    return TRUE;
+}
+
+// run a program by walking its tree, reading input from in and
+// writing output to out; return FALSE on a runtime error
+int evaluate(TreeNode *t, FILE *in, FILE *out) {
+    input = in;
+    output = out;
+    st_init(&proc_table);
+    st_init(&var_table);
+    vars = NULL;
+    var_num = 0;
+    var_capacity = 0;
+
+    // collect procedure definitions
+    int proc_num = 0;
+    for (TreeNode *p = t; p != NULL && p->node_type == PROC_NODE; p = p->sibling) {
+        proc_num += 1;
+    }
+    procs = (TreeNode **)malloc((proc_num + 1) * sizeof(TreeNode *));
+    proc_num = 0;
+    for (; t != NULL && t->node_type == PROC_NODE; t = t->sibling) {
+        procs[proc_num] = t;
+        proc_num += 1;
+        st_insert(&proc_table, t->child[0]->attr.name)->value = proc_num;
+    }
+
+    int ok = run_main(t);
+    fflush(output);
+
+    free(procs);
+    free(vars);
+    st_free(&proc_table);
+    st_free(&var_table);
+    return ok;
+}
\ No newline at end of file
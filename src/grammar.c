@@ -0,0 +1,85 @@
+#include "grammar.h"
+
+// shorthands for symbols
+#define T(t) t ## _TOKEN
+#define N(n) NT(n ## _NT)
+#define A(a) ACT(a ## _ACTION, 0)
+#define NEW_STMT(s) ACT(NEW_STMT_ACTION, s ## _STMT)
+#define NEW_EXPR(e) ACT(NEW_EXPR_ACTION, e ## _EXPR)
+#define CHILD(i) ACT(CHILD_ACTION, i)
+
+// productions of the grammar in README.md, left-factored, with the
+// actions that build the same tree as the recursive descent parser
+const Production productions[] = {
+    // <program> := <proc-defs> <stmts>
+    { PROGRAM_NT, { A(NEW_LIST), N(PROC_DEFS), A(ENTER), N(STMT_LIST), A(LEAVE), END_RHS } },
+
+    // <proc-defs> := { <proc-def> }
+    { PROC_DEFS_NT, { N(PROC_DEF), A(APPEND), N(PROC_DEFS), END_RHS } },
+    { PROC_DEFS_NT, { END_RHS } },
+    // <proc-def> := "proc" <id> "begin" <stmts> "end"
+    { PROC_DEF_NT, { A(NEW_PROC), T(PROC), A(PROC_NAME), T(ID), A(FINISH), CHILD(0),
+                     T(BEGIN), N(STMTS), CHILD(1), T(END), A(FINISH), END_RHS } },
+
+    // <stmts> := { <stmt> ";" }
+    { STMTS_NT, { A(NEW_LIST), A(ENTER), N(STMT_LIST), A(LEAVE), END_RHS } },
+    { STMT_LIST_NT, { N(STMT), A(APPEND), T(SEMI), N(STMT_LIST), END_RHS } },
+    { STMT_LIST_NT, { END_RHS } },
+
+    // <read-stmt> := "read" <id>
+    { STMT_NT, { NEW_STMT(READ), T(READ), A(NAME), T(ID), A(FINISH), END_RHS } },
+    // <write-stmt> := "write" <expr>
+    { STMT_NT, { NEW_STMT(WRITE), T(WRITE), N(EXPR), CHILD(0), A(FINISH), END_RHS } },
+    // <if-stmt> := "if" <expr> "then" <stmts> [ "else" <stmts> ] "end"
+    { STMT_NT, { NEW_STMT(IF), T(IF), N(EXPR), CHILD(0), T(THEN), N(STMTS), CHILD(1),
+                 N(ELSE_PART), T(END), A(FINISH), END_RHS } },
+    { ELSE_PART_NT, { T(ELSE), N(STMTS), CHILD(2), END_RHS } },
+    { ELSE_PART_NT, { END_RHS } },
+    // <repeat-stmt> := "repeat" <stmts> "until" <expr>
+    { STMT_NT, { NEW_STMT(REPEAT), T(REPEAT), N(STMTS), CHILD(0), T(UNTIL), N(EXPR), CHILD(1),
+                 A(FINISH), END_RHS } },
+    // <break-stmt> := "break"
+    { STMT_NT, { NEW_STMT(BREAK), T(BREAK), A(FINISH), END_RHS } },
+    // <continue-stmt> := "continue"
+    { STMT_NT, { NEW_STMT(CONTINUE), T(CONTINUE), A(FINISH), END_RHS } },
+    // <assign-stmt> := <id> ":=" <expr>
+    { STMT_NT, { NEW_STMT(ASSIGN), A(NAME), T(ID), T(ASSIGN), N(EXPR), CHILD(0), A(FINISH),
+                 END_RHS } },
+    // <proc-call-stmt> := "call" <id>
+    { STMT_NT, { NEW_STMT(PROC_CALL), T(CALL), A(NAME), T(ID), A(FINISH), END_RHS } },
+
+    // <expr> := <single-expr> [ ("<" | "=") <single-expr> ]
+    { EXPR_NT, { A(ENTER), N(SIMPLE_EXPR), N(CMP_TAIL), A(LEAVE), END_RHS } },
+    { CMP_TAIL_NT, { A(OP), T(LT), N(SIMPLE_EXPR), CHILD(1), A(FINISH), END_RHS } },
+    { CMP_TAIL_NT, { A(OP), T(EQ), N(SIMPLE_EXPR), CHILD(1), A(FINISH), END_RHS } },
+    { CMP_TAIL_NT, { END_RHS } },
+    // <single-expr> := <term> { ("+" | "-") <term> }
+    // (each operator nests the tree built so far one level deeper)
+    { SIMPLE_EXPR_NT, { N(TERM), N(ADD_TAIL), END_RHS } },
+    { ADD_TAIL_NT, { A(ENTER), A(OP), T(ADD), N(TERM), CHILD(1), A(FINISH), N(ADD_TAIL),
+                     A(LEAVE), END_RHS } },
+    { ADD_TAIL_NT, { A(ENTER), A(OP), T(SUB), N(TERM), CHILD(1), A(FINISH), N(ADD_TAIL),
+                     A(LEAVE), END_RHS } },
+    { ADD_TAIL_NT, { END_RHS } },
+    // <term> := <factor> { ("*" | "/") <factor> }
+    { TERM_NT, { N(FACTOR), N(MUL_TAIL), END_RHS } },
+    { MUL_TAIL_NT, { A(ENTER), A(OP), T(MUL), N(FACTOR), CHILD(1), A(FINISH), N(MUL_TAIL),
+                     A(LEAVE), END_RHS } },
+    { MUL_TAIL_NT, { A(ENTER), A(OP), T(DIV), N(FACTOR), CHILD(1), A(FINISH), N(MUL_TAIL),
+                     A(LEAVE), END_RHS } },
+    { MUL_TAIL_NT, { END_RHS } },
+    // <factor> := "(" <expr> ")" | <id> | <integer> | <float>
+    { FACTOR_NT, { A(PAREN_OPEN), T(LPAREN), N(EXPR), T(RPAREN), A(PAREN_CLOSE), END_RHS } },
+    { FACTOR_NT, { NEW_EXPR(ID), T(ID), A(FINISH), END_RHS } },
+    { FACTOR_NT, { NEW_EXPR(INTEGER), T(INTEGER), A(FINISH), END_RHS } },
+    { FACTOR_NT, { NEW_EXPR(FLOAT), T(FLOAT), A(FINISH), END_RHS } }
+};
+
+// the number of productions
+const int production_num = sizeof(productions) / sizeof(productions[0]);
+
+// names of nonterminals
+const char *nonterminal_names[NT_NUM] = {
+    "program", "proc-defs", "proc-def", "stmts", "stmt-list", "stmt", "else-part",
+    "expr", "cmp-tail", "single-expr", "add-tail", "term", "mul-tail", "factor"
+};
\ No newline at end of file
@@ -0,0 +1,643 @@
+#include "jit.h"
+#include "types.h"
+#include "parser.h"
+#include "symtab.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#if defined(__x86_64__)
+
+// The code is made of fixed instruction templates. Registers:
+//   rbx         variables, 16 bytes each
+//   ecx, rax    value of the last expression: ecx is 1 for a float, and
+//               rax holds the int in eax or the bits of the double
+//   rdx, esi    value of the right operand of a binary operator
+// Operands waiting for the right side are pushed as 16 bytes, so the stack
+// stays aligned for the calls to the helpers.
+
+// a variable: a tag and an int or the bits of a double
+typedef struct {
+    long is_float;
+    long bits;
+} Slot;
+
+struct JitProgram {
+    // executable memory
+    unsigned char *code;
+    long size;
+    // offset of the main program in code
+    long main_start;
+    // the number of variables
+    int var_num;
+};
+
+// machine code being generated
+static unsigned char *code;
+static long code_size;
+static long code_capacity;
+
+// variable name -> 1 + index of its slot
+static SymTab var_table;
+static int var_num;
+// procedure name -> 1 + index in procs
+static SymTab proc_table;
+static TreeNode **procs;
+// offset of the code of each procedure
+static long *proc_starts;
+
+// calls to procedures, patched once every procedure has its code
+typedef struct {
+    // offset of the 32-bit displacement of the call
+    long at;
+    int proc;
+} ProcCall;
+static ProcCall *calls;
+static int call_num;
+static int call_capacity;
+
+// jumps to be patched once their target is known
+typedef struct {
+    // offsets of the 32-bit displacements
+    long *at;
+    int num;
+    int capacity;
+} JumpList;
+
+// jumps out of the innermost repeat
+typedef struct {
+    JumpList breaks;
+    JumpList continues;
+} Loop;
+static Loop *current_loop;
+
+static FILE *input;
+static FILE *output;
+// where to go on a runtime error
+static jmp_buf error_exit;
+
+// append machine code
+static void emit(const unsigned char *bytes, int size) {
+    if (code_size + size > code_capacity) {
+        while (code_size + size > code_capacity) {
+            code_capacity = code_capacity ? code_capacity * 2 : 4096;
+        }
+        code = (unsigned char *)realloc(code, code_capacity);
+    }
+    memcpy(code + code_size, bytes, size);
+    code_size += size;
+}
+
+// append instruction bytes
+#define EMIT(...) emit((const unsigned char[]){ __VA_ARGS__ }, \
+                       sizeof((const unsigned char[]){ __VA_ARGS__ }))
+
+// append a 32-bit immediate or displacement
+static void emit_int32(int value) {
+    emit((const unsigned char *)&value, 4);
+}
+
+// append a 64-bit immediate
+static void emit_int64(long value) {
+    emit((const unsigned char *)&value, 8);
+}
+
+// opcodes of jumps with a 32-bit displacement
+#define JMP 0xE9
+#define JZ 0x84
+#define JNZ 0x85
+
+// append a jump to be patched, and return the offset of its displacement
+static long emit_jump(int opcode) {
+    if (opcode == JMP) {
+        EMIT(JMP);
+    }
+    else {
+        EMIT(0x0F, opcode);
+    }
+    emit_int32(0);
+    return code_size - 4;
+}
+
+// make the displacement at an offset point to a target
+static void patch(long at, long target) {
+    int displacement = target - (at + 4);
+    memcpy(code + at, &displacement, 4);
+}
+
+// append a call to a helper in C: mov rax, helper; call rax
+static void emit_call(void *helper) {
+    EMIT(0x48, 0xB8);
+    emit_int64((long)helper);
+    EMIT(0xFF, 0xD0);
+}
+
+// offset of a variable from rbx, giving it a slot the first time
+static int var_offset(const char *name) {
+    Symbol *s = st_insert(&var_table, name);
+    if (s->value == 0) {
+        var_num += 1;
+        s->value = var_num;
+    }
+    return (s->value - 1) * (int)sizeof(Slot);
+}
+
+// print runtime error message and stop the program
+static void runtime_error(long offset, char *message) {
+    report_error("Runtime", offset, "%s", message);
+    longjmp(error_exit, 1);
+}
+
+// helper: integer division by zero
+static void division_by_zero(long offset) {
+    runtime_error(offset, "Division by zero");
+}
+
+// helper: a call to a procedure that is not defined
+static void undefined_procedure(long offset) {
+    runtime_error(offset, "Undefined procedure");
+}
+
+// helper: read a number, float if it has a '.', as eval.c does
+static void read_slot(Slot *slot, long offset) {
+    char buf[64];
+    char *end;
+    if (fscanf(input, "%63s", buf) != 1) {
+        runtime_error(offset, "Missing input");
+    }
+    int is_float = FALSE;
+    for (char *p = buf; *p != '\0'; p++) {
+        is_float |= (*p == '.');
+    }
+    if (is_float) {
+        double f = strtod(buf, &end);
+        slot->is_float = TRUE;
+        memcpy(&slot->bits, &f, sizeof(f));
+    }
+    else {
+        slot->is_float = FALSE;
+        slot->bits = (int)strtol(buf, &end, 10);
+    }
+    if (*end != '\0') {
+        runtime_error(offset, "Input is not a number");
+    }
+}
+
+// helper: write a value on its own line
+static void write_value(int is_float, long bits) {
+    if (is_float) {
+        double f;
+        memcpy(&f, &bits, sizeof(f));
+        fprintf(output, "%g\n", f);
+    }
+    else {
+        fprintf(output, "%d\n", (int)bits);
+    }
+}
+
+// compile an operator on two integers in eax and edx, leaving the result
+// in eax (arithmetic wraps around)
+static void compile_int_op(TreeNode *t) {
+    switch (t->attr.op) {
+        case ADD_TOKEN:
+            // add eax, edx
+            EMIT(0x01, 0xD0);
+            break;
+        case SUB_TOKEN:
+            // sub eax, edx
+            EMIT(0x29, 0xD0);
+            break;
+        case MUL_TOKEN:
+            // imul eax, edx
+            EMIT(0x0F, 0xAF, 0xC2);
+            break;
+        case DIV_TOKEN: {
+            // test edx, edx; jnz divide; call the helper
+            EMIT(0x85, 0xD2);
+            long nonzero = emit_jump(JNZ);
+            // mov rdi, source offset
+            EMIT(0x48, 0xBF);
+            emit_int64(t->span.start);
+            emit_call(division_by_zero);
+            patch(nonzero, code_size);
+            // INT_MIN / -1 is INT_MIN, which is already in eax:
+            // cmp edx, -1; jnz divide; cmp eax, INT_MIN; jz done
+            EMIT(0x83, 0xFA, 0xFF);
+            long not_minus_one = emit_jump(JNZ);
+            EMIT(0x3D, 0x00, 0x00, 0x00, 0x80);
+            long overflow = emit_jump(JZ);
+            patch(not_minus_one, code_size);
+            // mov esi, edx; cdq; idiv esi
+            EMIT(0x89, 0xD6, 0x99, 0xF7, 0xFE);
+            patch(overflow, code_size);
+            break;
+        }
+        case LT_TOKEN:
+            // cmp eax, edx; setl al; movzx eax, al
+            EMIT(0x39, 0xD0, 0x0F, 0x9C, 0xC0, 0x0F, 0xB6, 0xC0);
+            break;
+        default:
+            // cmp eax, edx; sete al; movzx eax, al
+            EMIT(0x39, 0xD0, 0x0F, 0x94, 0xC0, 0x0F, 0xB6, 0xC0);
+            break;
+    }
+}
+
+// compile an expression, leaving its value in ecx and rax
+static void compile_expr(TreeNode *t) {
+    switch (t->type.expr_type) {
+        case ID_EXPR: {
+            int offset = var_offset(t->attr.name);
+            // mov rcx, [rbx + offset]; mov rax, [rbx + offset + 8]
+            EMIT(0x48, 0x8B, 0x8B);
+            emit_int32(offset);
+            EMIT(0x48, 0x8B, 0x83);
+            emit_int32(offset + 8);
+            return;
+        }
+        case INTEGER_EXPR:
+            // xor ecx, ecx; mov eax, value
+            EMIT(0x31, 0xC9, 0xB8);
+            emit_int32(t->attr.integer_val);
+            return;
+        case FLOAT_EXPR: {
+            double f = t->attr.float_val;
+            long bits;
+            memcpy(&bits, &f, sizeof(bits));
+            // mov ecx, 1; mov rax, bits
+            EMIT(0xB9, 0x01, 0x00, 0x00, 0x00, 0x48, 0xB8);
+            emit_int64(bits);
+            return;
+        }
+        default:
+            break;
+    }
+    compile_expr(t->child[0]);
+    // push rcx; push rax
+    EMIT(0x51, 0x50);
+    compile_expr(t->child[1]);
+    // mov rdx, rax; mov esi, ecx; pop rax; pop rcx
+    EMIT(0x48, 0x89, 0xC2, 0x89, 0xCE, 0x58, 0x59);
+    // operands whose type infer_types() found need no check of their tags
+    ValueType left = t->child[0]->value_type;
+    ValueType right = t->child[1]->value_type;
+    int is_int = left == INT_TYPE && right == INT_TYPE;
+    int is_float = !is_int && (left == INT_TYPE || left == FLOAT_TYPE)
+                   && (right == INT_TYPE || right == FLOAT_TYPE);
+    long to_float = 0;
+    long to_end = 0;
+    if (!is_int && !is_float) {
+        // mov edi, ecx; or edi, esi
+        EMIT(0x89, 0xCF, 0x09, 0xF7);
+        to_float = emit_jump(JNZ);
+    }
+    if (!is_float) {
+        compile_int_op(t);
+        if (is_int) {
+            return;
+        }
+        to_end = emit_jump(JMP);
+        patch(to_float, code_size);
+    }
+
+    // float if either side is float: left to xmm0, right to xmm1
+    if (is_float) {
+        // movq xmm0, rax or cvtsi2sd xmm0, eax
+        if (left == FLOAT_TYPE) {
+            EMIT(0x66, 0x48, 0x0F, 0x6E, 0xC0);
+        }
+        else {
+            EMIT(0xF2, 0x0F, 0x2A, 0xC0);
+        }
+        // movq xmm1, rdx or cvtsi2sd xmm1, edx
+        if (right == FLOAT_TYPE) {
+            EMIT(0x66, 0x48, 0x0F, 0x6E, 0xCA);
+        }
+        else {
+            EMIT(0xF2, 0x0F, 0x2A, 0xCA);
+        }
+    }
+    else {
+        // test ecx, ecx; jz +7; movq xmm0, rax; jmp +4; cvtsi2sd xmm0, eax
+        EMIT(0x85, 0xC9, 0x74, 0x07, 0x66, 0x48, 0x0F, 0x6E, 0xC0, 0xEB, 0x04,
+             0xF2, 0x0F, 0x2A, 0xC0);
+        // test esi, esi; jz +7; movq xmm1, rdx; jmp +4; cvtsi2sd xmm1, edx
+        EMIT(0x85, 0xF6, 0x74, 0x07, 0x66, 0x48, 0x0F, 0x6E, 0xCA, 0xEB, 0x04,
+             0xF2, 0x0F, 0x2A, 0xCA);
+    }
+    switch (t->attr.op) {
+        case LT_TOKEN:
+            // ucomisd xmm1, xmm0; seta al; movzx eax, al; xor ecx, ecx
+            // (false if either is NaN)
+            EMIT(0x66, 0x0F, 0x2E, 0xC8, 0x0F, 0x97, 0xC0, 0x0F, 0xB6, 0xC0, 0x31, 0xC9);
+            break;
+        case EQ_TOKEN:
+            // ucomisd xmm0, xmm1; sete al; setnp dl; and al, dl; movzx eax, al;
+            // xor ecx, ecx
+            EMIT(0x66, 0x0F, 0x2E, 0xC1, 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC2, 0x20, 0xD0,
+                 0x0F, 0xB6, 0xC0, 0x31, 0xC9);
+            break;
+        default:
+            // addsd, subsd, mulsd or divsd xmm0, xmm1
+            EMIT(0xF2, 0x0F, t->attr.op == ADD_TOKEN ? 0x58 : t->attr.op == SUB_TOKEN ? 0x5C
+                             : t->attr.op == MUL_TOKEN ? 0x59 : 0x5E, 0xC1);
+            // movq rax, xmm0; mov ecx, 1
+            EMIT(0x66, 0x48, 0x0F, 0x7E, 0xC0, 0xB9, 0x01, 0x00, 0x00, 0x00);
+            break;
+    }
+    if (!is_float) {
+        patch(to_end, code_size);
+    }
+}
+
+// compile a condition and a jump taken if it's false, and return the
+// offset of the jump's displacement
+static long compile_jump_if_false(TreeNode *t) {
+    compile_expr(t);
+    // a float is true unless it's 0 or -0, so test its bits without the sign
+    if (t->value_type == INT_TYPE) {
+        // test eax, eax
+        EMIT(0x85, 0xC0);
+    }
+    else if (t->value_type == FLOAT_TYPE) {
+        // add rax, rax
+        EMIT(0x48, 0x01, 0xC0);
+    }
+    else {
+        // test ecx, ecx; jz +5; add rax, rax; jmp +2; test eax, eax
+        EMIT(0x85, 0xC9, 0x74, 0x05, 0x48, 0x01, 0xC0, 0xEB, 0x02, 0x85, 0xC0);
+    }
+    return emit_jump(JZ);
+}
+
+// add a jump to a list
+static void add_jump(JumpList *list, long at) {
+    if (list->num == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 4;
+        list->at = (long *)realloc(list->at, list->capacity * sizeof(long));
+    }
+    list->at[list->num] = at;
+    list->num += 1;
+}
+
+// point the jumps of a list to a target and free the list
+static void patch_jumps(JumpList *list, long target) {
+    for (int i = 0; i < list->num; i++) {
+        patch(list->at[i], target);
+    }
+    free(list->at);
+}
+
+static void compile_stmts(TreeNode *t);
+
+// compile a statement
+static void compile_stmt(TreeNode *t) {
+    switch (t->type.stmt_type) {
+        case READ_STMT:
+            // lea rdi, [rbx + offset]; mov rsi, source offset
+            EMIT(0x48, 0x8D, 0xBB);
+            emit_int32(var_offset(t->attr.name));
+            EMIT(0x48, 0xBE);
+            emit_int64(t->span.start);
+            emit_call(read_slot);
+            break;
+        case WRITE_STMT:
+            compile_expr(t->child[0]);
+            // mov edi, ecx; mov rsi, rax
+            EMIT(0x89, 0xCF, 0x48, 0x89, 0xC6);
+            emit_call(write_value);
+            break;
+        case IF_STMT: {
+            long to_else = compile_jump_if_false(t->child[0]);
+            compile_stmts(t->child[1]);
+            if (t->child[2] != NULL) {
+                long to_end = emit_jump(JMP);
+                patch(to_else, code_size);
+                compile_stmts(t->child[2]);
+                patch(to_end, code_size);
+            }
+            else {
+                patch(to_else, code_size);
+            }
+            break;
+        }
+        case REPEAT_STMT: {
+            // continue goes on to the condition, like in a C do-while
+            Loop loop = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+            Loop *outer_loop = current_loop;
+            current_loop = &loop;
+            long top = code_size;
+            compile_stmts(t->child[0]);
+            current_loop = outer_loop;
+            patch_jumps(&loop.continues, code_size);
+            patch(compile_jump_if_false(t->child[1]), top);
+            patch_jumps(&loop.breaks, code_size);
+            break;
+        }
+        case BREAK_STMT:
+            add_jump(&current_loop->breaks, emit_jump(JMP));
+            break;
+        case CONTINUE_STMT:
+            add_jump(&current_loop->continues, emit_jump(JMP));
+            break;
+        case ASSIGN_STMT: {
+            compile_expr(t->child[0]);
+            int offset = var_offset(t->attr.name);
+            // mov [rbx + offset], rcx; mov [rbx + offset + 8], rax
+            EMIT(0x48, 0x89, 0x8B);
+            emit_int32(offset);
+            EMIT(0x48, 0x89, 0x83);
+            emit_int32(offset + 8);
+            break;
+        }
+        case PROC_CALL_STMT: {
+            Symbol *s = st_lookup(&proc_table, t->attr.name);
+            if (s == NULL) {
+                // only in a procedure that is never called, as analyze()
+                // checks the others
+                // mov rdi, source offset
+                EMIT(0x48, 0xBF);
+                emit_int64(t->span.start);
+                emit_call(undefined_procedure);
+                break;
+            }
+            // call rel32, patched once the procedure has its code
+            EMIT(0xE8);
+            emit_int32(0);
+            if (call_num == call_capacity) {
+                call_capacity = call_capacity ? call_capacity * 2 : 16;
+                calls = (ProcCall *)realloc(calls, call_capacity * sizeof(ProcCall));
+            }
+            calls[call_num++] = (ProcCall){ code_size - 4, s->value - 1 };
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// compile a statement list
+static void compile_stmts(TreeNode *t) {
+    for (; t != NULL; t = t->sibling) {
+        compile_stmt(t);
+    }
+}
+
+// compile the statements of a procedure or the main program; a break or
+// continue outside a repeat returns, as it ends the list in eval.c
+static void compile_body(TreeNode *t) {
+    Loop loop = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+    current_loop = &loop;
+    compile_stmts(t);
+    current_loop = NULL;
+    patch_jumps(&loop.breaks, code_size);
+    patch_jumps(&loop.continues, code_size);
+}
+
+// compile a program to x86-64 code, or print why it can't and return NULL
+// (the tree must have passed analyze())
+JitProgram* jit_compile(TreeNode *t) {
+    // operators whose operand types are known skip the checks of the tags
+    infer_types(t);
+    code = NULL;
+    code_size = 0;
+    code_capacity = 0;
+    st_init(&var_table);
+    var_num = 0;
+    st_init(&proc_table);
+    calls = NULL;
+    call_num = 0;
+    call_capacity = 0;
+
+    // collect procedure definitions
+    int proc_num = 0;
+    for (TreeNode *p = t; p != NULL && p->node_type == PROC_NODE; p = p->sibling) {
+        proc_num += 1;
+    }
+    procs = (TreeNode **)malloc((proc_num + 1) * sizeof(TreeNode *));
+    proc_starts = (long *)malloc((proc_num + 1) * sizeof(long));
+    proc_num = 0;
+    for (; t != NULL && t->node_type == PROC_NODE; t = t->sibling) {
+        procs[proc_num] = t;
+        proc_num += 1;
+        st_insert(&proc_table, t->child[0]->attr.name)->value = proc_num;
+    }
+
+    // procedures: push rbp; body; pop rbp; ret
+    // (rbx is set by the main program, and the call keeps the stack aligned)
+    for (int i = 0; i < proc_num; i++) {
+        proc_starts[i] = code_size;
+        EMIT(0x55);
+        compile_body(proc_body(procs[i]));
+        EMIT(0x5D, 0xC3);
+    }
+    // main program, called as void main(Slot *vars):
+    // push rbp; push rbx; push r12; mov rbx, rdi; body; pop r12; pop rbx; pop rbp; ret
+    long main_start = code_size;
+    EMIT(0x55, 0x53, 0x41, 0x54, 0x48, 0x89, 0xFB);
+    compile_body(t);
+    EMIT(0x41, 0x5C, 0x5B, 0x5D, 0xC3);
+    for (int i = 0; i < call_num; i++) {
+        patch(calls[i].at, proc_starts[calls[i].proc]);
+    }
+
+    // copy the code to executable memory, which is never writable and
+    // executable at once
+    JitProgram *program = (JitProgram *)malloc(sizeof(JitProgram));
+    program->size = code_size;
+    program->main_start = main_start;
+    program->var_num = var_num;
+    program->code = (unsigned char *)mmap(NULL, code_size, PROT_READ | PROT_WRITE,
+                                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (program->code == MAP_FAILED) {
+        fprintf(stderr, "Can't map memory for the JIT: %s\n", strerror(errno));
+        free(program);
+        program = NULL;
+    }
+    else {
+        memcpy(program->code, code, code_size);
+        if (mprotect(program->code, code_size, PROT_READ | PROT_EXEC) != 0) {
+            fprintf(stderr, "Can't make the JIT code executable: %s\n", strerror(errno));
+            munmap(program->code, code_size);
+            free(program);
+            program = NULL;
+        }
+    }
+
+    free(code);
+    free(calls);
+    free(procs);
+    free(proc_starts);
+    st_free(&var_table);
+    st_free(&proc_table);
+    return program;
+}
+
+// call the main program, or return FALSE when a runtime error jumps out
+// (nothing is changed after setjmp, so longjmp can't clobber it)
+static int run_code(void (*main_code)(Slot *), Slot *vars) {
+    if (setjmp(error_exit) != 0) {
+        return FALSE;
+    }
+    main_code(vars);
+    return TRUE;
+}
+
+// run a compiled program, reading input from in and writing output to out;
+// return FALSE on a runtime error
+int jit_execute(JitProgram *program, FILE *in, FILE *out) {
+    input = in;
+    output = out;
+    Slot *vars = (Slot *)calloc(program->var_num + 1, sizeof(Slot));
+    void (*main_code)(Slot *) = (void (*)(Slot *))(program->code + program->main_start);
+    int ok = run_code(main_code, vars);
+    fflush(output);
+    free(vars);
+    return ok;
+}
+
+// bytes of machine code in a compiled program
+long jit_code_size(const JitProgram *program) {
+    return program->size;
+}
+
+// free the code of a compiled program
+void jit_free(JitProgram *program) {
+    if (program != NULL) {
+        munmap(program->code, program->size);
+        free(program);
+    }
+}
+
+#else
+
+// compile a program to x86-64 code, or print why it can't and return NULL
+JitProgram* jit_compile(TreeNode *t) {
+    (void)t;
+    fprintf(stderr, "The JIT needs an x86-64 machine\n");
+    return NULL;
+}
+
+// run a compiled program
+int jit_execute(JitProgram *program, FILE *in, FILE *out) {
+    (void)program;
+    (void)in;
+    (void)out;
+    return FALSE;
+}
+
+// bytes of machine code in a compiled program
+long jit_code_size(const JitProgram *program) {
+    (void)program;
+    return 0;
+}
+
+// free the code of a compiled program
+void jit_free(JitProgram *program) {
+    (void)program;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "ll1.h"
+#include "grammar.h"
+#include "ll1_table.h"
+#include "syntax.h"
+#include "scanner.h"
+#include "tree.h"
+#include "util.h"
+#include "budget.h"
+#include <stdlib.h>
+#include <string.h>
+
+// a value on the semantic stack
+typedef struct {
+    // node, or first node of a list
+    TreeNode *node;
+    // last node of a list
+    TreeNode *tail;
+    // offset of "(" for parentheses
+    long start;
+} Value;
+
+// parse stack of symbols still to match or expand
+static short *symbols = NULL;
+static int symbol_num = 0;
+static int symbol_capacity = 0;
+// semantic stack of trees being built
+static Value *values = NULL;
+static int value_num = 0;
+static int value_capacity = 0;
+
+// make room for more symbols on the parse stack
+static inline void reserve_symbols(int num) {
+    if (symbol_num + num > symbol_capacity) {
+        while (symbol_num + num > symbol_capacity) {
+            symbol_capacity = symbol_capacity ? symbol_capacity * 2 : 256;
+        }
+        symbols = (short *)realloc(symbols, symbol_capacity * sizeof(short));
+    }
+}
+
+// push a value onto the semantic stack
+static inline void push_value(TreeNode *node, long start) {
+    if (value_num == value_capacity) {
+        value_capacity = value_capacity ? value_capacity * 2 : 256;
+        values = (Value *)realloc(values, value_capacity * sizeof(Value));
+    }
+    values[value_num++] = (Value){ node, node, start };
+}
+
+// run a semantic action
+static void run_action(int action, int arg) {
+    // the value on top, actions that pop one look below it
+    Value *top = value_num > 0 ? &values[value_num - 1] : NULL;
+    switch (action) {
+        case NEW_LIST_ACTION:
+            push_value(NULL, 0);
+            break;
+        case APPEND_ACTION: {
+            TreeNode *q = values[--value_num].node;
+            top = &values[value_num - 1];
+            if (q != NULL) {
+                if (top->node == NULL) {
+                    top->node = q;
+                }
+                else {
+                    top->tail->sibling = q;
+                }
+                top->tail = q;
+            }
+            break;
+        }
+        case ENTER_ACTION:
+            budget_enter();
+            break;
+        case LEAVE_ACTION:
+            budget_leave(1);
+            break;
+        case NEW_PROC_ACTION:
+            push_value(new_proc_node(), 0);
+            break;
+        case NEW_STMT_ACTION:
+            push_value(new_stmt_node(arg), 0);
+            break;
+        case NEW_EXPR_ACTION: {
+            TreeNode *t = new_expr_node(arg);
+            if (t != NULL) {
+                if (arg == ID_EXPR) {
+                    t->attr.name = copy_string(lexeme);
+                }
+                else if (arg == INTEGER_EXPR) {
+                    t->attr.integer_val = atoi(lexeme);
+                }
+                else {
+                    t->attr.float_val = atof(lexeme);
+                }
+            }
+            push_value(t, 0);
+            break;
+        }
+        case NAME_ACTION:
+            if (top->node != NULL && current_token == ID_TOKEN) {
+                top->node->attr.name = copy_string(lexeme);
+            }
+            break;
+        case PROC_NAME_ACTION: {
+            TreeNode *p = new_expr_node(ID_EXPR);
+            if (p != NULL && current_token == ID_TOKEN) {
+                p->attr.name = copy_string(lexeme);
+            }
+            push_value(p, 0);
+            break;
+        }
+        case CHILD_ACTION: {
+            TreeNode *child = values[--value_num].node;
+            top = &values[value_num - 1];
+            if (top->node != NULL) {
+                top->node->child[arg] = child;
+            }
+            else {
+                free_tree(child);
+            }
+            break;
+        }
+        case FINISH_ACTION:
+            finish_node(top->node);
+            break;
+        case OP_ACTION: {
+            // the operator is the lookahead that chose the production
+            TreeNode *t = new_op_node(top->node);
+            if (t != NULL) {
+                top->node = t;
+                top->tail = t;
+            }
+            break;
+        }
+        case PAREN_OPEN_ACTION:
+            push_value(NULL, token_span.start);
+            break;
+        case PAREN_CLOSE_ACTION: {
+            // the span includes the parentheses
+            TreeNode *t = values[--value_num].node;
+            top = &values[value_num - 1];
+            if (t != NULL) {
+                t->span.start = top->start;
+                finish_node(t);
+            }
+            top->node = t;
+            top->tail = t;
+            break;
+        }
+    }
+}
+
+// parse and return a new syntax tree with the table-driven LL(1) parser
+TreeNode* ll1_parse(void) {
+    budget_start();
+    current_token = get_next_token();
+    symbol_num = 0;
+    value_num = 0;
+    reserve_symbols(1);
+    symbols[symbol_num++] = NT(PROGRAM_NT);
+    while (symbol_num > 0 && !SYNTAX_ERROR) {
+        int s = symbols[--symbol_num];
+        if (s < NT_BASE) {
+            // terminal: match it
+            if ((int)current_token == s) {
+                advance_token();
+            }
+            else {
+                unexpected_token();
+            }
+        }
+        else if (s < ACTION_BASE) {
+            // nonterminal: expand it by the production the lookahead predicts
+            int p = predict_table[s - NT_BASE][current_token];
+            if (p < 0) {
+                unexpected_token();
+                break;
+            }
+            int length = rhs_length[p];
+            reserve_symbols(length);
+            memcpy(symbols + symbol_num, reversed_rhs[p], length * sizeof(short));
+            symbol_num += length;
+        }
+        else {
+            s -= ACTION_BASE;
+            run_action(s / ACTION_ARGS, s % ACTION_ARGS);
+        }
+    }
+    if (!SYNTAX_ERROR && current_token != ENDFILE_TOKEN) {
+        // syntax error
+        syntax_error("Code ends before file!");
+    }
+    // the program is the list at the bottom, a syntax error leaves
+    // unfinished trees above it
+    TreeNode *t = value_num > 0 ? values[0].node : NULL;
+    if (SYNTAX_ERROR) {
+        for (int i = 0; i < value_num; i++) {
+            free_tree(values[i].node);
+        }
+        t = NULL;
+    }
+    return t;
+}
\ No newline at end of file
@@ -1,48 +1,454 @@
 #include "parser.h"
+#include "scanner.h"
 #include "tree.h"
+#include "analyze.h"
+#include "eval.h"
+#include "emit.h"
+#include "jit.h"
+#include "types.h"
+#include "diff.h"
+#include "query.h"
+#include "bench.h"
+#include "budget.h"
+#include "reader.h"
+#include "watch.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
 
-// source code file
-FILE *src_file;
-// result file
-FILE *result_file;
+// what to do with each source file
+typedef enum {
+    // print the AST
+    AST_MODE,
+    // print procedure names and the main program only
+    OUTLINE_MODE,
+    // run the program with the tree-walking evaluator
+    RUN_MODE,
+    // run the program compiled to machine code
+    JIT_MODE,
+    // run the program both ways and compare the output
+    JIT_CHECK_MODE,
+    // translate the program to C
+    EMIT_C_MODE,
+    // run the program translated to C and with the evaluator, and compare
+    BENCH_EMIT_MODE,
+    // print the inferred types
+    TYPES_MODE,
+    // print the token stream
+    TOKENS_MODE,
+    // benchmark the scanner
+    BENCH_LEX_MODE,
+    // benchmark both parsers
+    BENCH_PARSE_MODE,
+    // compare the trees of two files
+    DIFF_MODE,
+    // print the nodes matching paths
+    QUERY_MODE
+} RunMode;
 
-// index of current source code line
-int line_idx = 0;
+// print usage and exit
+static void usage(char *prog) {
+    fprintf(stderr, "usage: %s [options] <filename>...\n", prog);
+    fprintf(stderr, "       %s [options] --watch=DIR\n", prog);
+    fprintf(stderr, "  --outline         print the AST without parsing procedure bodies\n");
+    fprintf(stderr, "  --spans           print [line:column-line:column] of each node\n");
+    fprintf(stderr, "  --run             run the program with the reference evaluator\n");
+    fprintf(stderr, "  --jit             run the program compiled to x86-64 machine code\n");
+    fprintf(stderr, "  --jit-check       run the program with both and compare the output\n");
+    fprintf(stderr, "  --emit-c          print the program translated to C\n");
+    fprintf(stderr, "  --bench-emit      build the C translation with $CC and time it against --run\n");
+    fprintf(stderr, "  --types           print the type of each variable and the operations\n");
+    fprintf(stderr, "                    that can skip type checks\n");
+    fprintf(stderr, "  --diff            print the statements changed from the first file to the second\n");
+    fprintf(stderr, "  --query=PATH      print the nodes matching PATH, e.g. \"repeat//assign[x]\"\n");
+    fprintf(stderr, "                    (may be given more than once)\n");
+    fprintf(stderr, "  --tokens          print the token stream instead of the AST\n");
+    fprintf(stderr, "  --watch=DIR       print the AST of each .tny file in DIR again when it changes\n");
+    fprintf(stderr, "  --debounce=MS     wait until DIR is quiet for MS ms before printing (default 100)\n");
+    fprintf(stderr, "  --threads=N       lex the file and print the AST with N threads\n");
+    fprintf(stderr, "                    (default 1), also with --tokens and --bench-lex\n");
+    fprintf(stderr, "  --bench-lex[=N]   time N scanner-only passes (default 10)\n");
+    fprintf(stderr, "  --bench-parse[=N] time N parses with each parser (default 10)\n");
+    fprintf(stderr, "  --ll1             parse with the table-driven LL(1) parser\n");
+    fprintf(stderr, "  --prefetch=N      read up to N files ahead of the parser (default 4)\n");
+    fprintf(stderr, "  --io-stats        print the time spent waiting for input to stderr\n");
+    fprintf(stderr, "resource limits (0 means no limit):\n");
+    fprintf(stderr, "  --max-depth=N     nesting depth (default %d)\n", budget.max_depth);
+    fprintf(stderr, "  --max-nodes=N     tree nodes\n");
+    fprintf(stderr, "  --max-bytes=N     bytes allocated for the tree\n");
+    fprintf(stderr, "  --max-token=N     characters in a token\n");
+    fprintf(stderr, "  --timeout=MS      wall-clock time of the parse\n");
+    exit(EXIT_FAILURE);
+}
 
-// check if there's any syntax error
-int SYNTAX_ERROR = FALSE;
+// current time in seconds
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
-int main(int argc, char **argv) {
-    // source code file name
-    char filename[256];
-    if (argc != 2) {
-        fprintf(stderr, "usage: %s <filename>\n", argv[0]);
-        exit(EXIT_FAILURE);
+// threads printing the AST
+static int print_threads = 1;
+
+// paths given with --query
+static char **query_paths = NULL;
+static int query_num = 0;
+
+// index the tree once and answer every query
+// (returns FALSE if a path is invalid)
+static int run_queries(TreeNode *ast) {
+    QueryIndex *index = query_index(ast);
+    int ok = TRUE;
+    for (int i = 0; i < query_num; i++) {
+        fprintf(result_file, "[========== Query: %s ==========]\n", query_paths[i]);
+        TreeNode **results;
+        int num = query_find(index, query_paths[i], &results);
+        if (num < 0) {
+            // the path is invalid, and query_find printed why
+            ok = FALSE;
+        }
+        for (int j = 0; j < num; j++) {
+            long start = results[j]->span.start;
+            fprintf(result_file, "%d:%d: ", offset_line(start), offset_column(start));
+            print_node(results[j]);
+        }
+    }
+    query_free(index);
+    return ok;
+}
+
+// tree of the first file in diff mode
+static TreeNode *old_tree = NULL;
+// lines of the first file in diff mode
+static LineTable old_lines = { NULL, 0, 0 };
+// hash of the first tree in diff mode
+static uint64_t old_hash = 0;
+
+// parse and hash a file, and compare it to the one before
+// (returns FALSE if it has a syntax error)
+static int diff_source(void) {
+    TreeNode *ast = parse();
+    if (SYNTAX_ERROR) {
+        free_tree(ast);
+        return FALSE;
+    }
+    uint64_t hash = hash_tree(ast);
+    if (old_lines.starts == NULL) {
+        // keep the first tree and its lines
+        old_tree = ast;
+        old_lines = line_table;
+        old_hash = hash;
+        line_table = (LineTable){ NULL, 0, 0 };
+        return TRUE;
     }
-    strcpy(filename, argv[1]);
+    if (hash == old_hash) {
+        fprintf(result_file, "No changes\n");
+    }
+    else {
+        diff_trees(old_tree, &old_lines, ast, &line_table);
+    }
+    free_tree(ast);
+    return TRUE;
+}
 
-    // open source code file
-    src_file = fopen(filename, "r");
-    if (src_file == NULL) {
-        fprintf(stderr, "File %s not found\n", filename);
-        exit(EXIT_FAILURE);
+// run a program compiled to machine code
+// (returns FALSE if it can't be compiled or on a runtime error)
+static int run_jit(TreeNode *ast) {
+    JitProgram *program = jit_compile(ast);
+    if (program == NULL) {
+        return FALSE;
+    }
+    int ok = jit_execute(program, stdin, result_file);
+    jit_free(program);
+    return ok;
+}
+
+// process the source code given to the scanner
+// (returns FALSE on a runtime error or an invalid query, or if the JIT
+// can't compile or a JIT check fails)
+static int run(RunMode mode, int bench_reps) {
+    int ok = TRUE;
+    if (mode == TOKENS_MODE && print_threads > 1) {
+        // lex in parallel, then print the tokens as get_next_token would
+        TokenArray tokens = { NULL, 0, 0 };
+        lex_parallel(print_threads, &tokens);
+        for (long i = 0; i < tokens.num; i++) {
+            token_span = tokens.tokens[i].span;
+            token_lexeme(&tokens.tokens[i], lexeme);
+            budget_check_token(token_span.length);
+            fprintf(result_file, "%d:%d: ", offset_line(token_span.start),
+                    offset_column(token_span.start));
+            print_token(tokens.tokens[i].type, lexeme);
+        }
+        free(tokens.tokens);
+    }
+    else if (mode == TOKENS_MODE) {
+        // print every token until end of file
+        TokenType token;
+        do {
+            token = get_next_token();
+            fprintf(result_file, "%d:%d: ", offset_line(token_span.start),
+                    offset_column(token_span.start));
+            print_token(token, lexeme);
+        } while (token != ENDFILE_TOKEN);
+    }
+    else if (mode == BENCH_LEX_MODE) {
+        bench_lex(bench_reps, print_threads);
+    }
+    else if (mode == BENCH_PARSE_MODE) {
+        bench_parse(bench_reps);
+    }
+    else if (mode == OUTLINE_MODE) {
+        // bodies stay unparsed, so they are not checked either
+        LAZY_PARSE = TRUE;
+        TreeNode *ast = parse();
+        if (!SYNTAX_ERROR) {
+            fprintf(result_file, "[========== Outline ==========]\n");
+            print_tree_parallel(ast, print_threads);
+        }
+        free_tree(ast);
+    }
+    else if (mode == QUERY_MODE) {
+        // queries only look at the structure, so semantic errors don't matter
+        TreeNode *ast = parse();
+        if (!SYNTAX_ERROR) {
+            ok = run_queries(ast);
+        }
+        free_tree(ast);
+    }
+    else {
+        // create ast and check it
+        TreeNode *ast = parse();
+        if (!SYNTAX_ERROR && analyze(ast) == 0) {
+            if (mode == RUN_MODE) {
+                ok = evaluate(ast, stdin, result_file);
+            }
+            else if (mode == JIT_MODE) {
+                ok = run_jit(ast);
+            }
+            else if (mode == JIT_CHECK_MODE) {
+                ok = bench_jit(ast, stdin);
+            }
+            else if (mode == EMIT_C_MODE) {
+                emit_c(ast);
+            }
+            else if (mode == BENCH_EMIT_MODE) {
+                ok = bench_emit(ast, stdin);
+            }
+            else if (mode == TYPES_MODE) {
+                print_types(ast);
+            }
+            else {
+                fprintf(result_file, "[========== AST ==========]\n");
+                print_tree_parallel(ast, print_threads);
+            }
+        }
+
+        // free ast
+        free_tree(ast);
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    RunMode mode = AST_MODE;
+    int bench_reps = 10;
+    int prefetch_depth = 4;
+    int io_stats = FALSE;
+    char *watch_dir = NULL;
+    int debounce_millis = 100;
+
+    static struct option long_options[] = {
+        { "outline", no_argument, NULL, 'o' },
+        { "spans", no_argument, NULL, 's' },
+        { "run", no_argument, NULL, 'r' },
+        { "jit", no_argument, NULL, 'J' },
+        { "jit-check", no_argument, NULL, 'K' },
+        { "emit-c", no_argument, NULL, 'c' },
+        { "bench-emit", no_argument, NULL, 'E' },
+        { "types", no_argument, NULL, 'y' },
+        { "diff", no_argument, NULL, 'D' },
+        { "query", required_argument, NULL, 'q' },
+        { "tokens", no_argument, NULL, 't' },
+        { "watch", required_argument, NULL, 'w' },
+        { "debounce", required_argument, NULL, 'B' },
+        { "threads", required_argument, NULL, 'j' },
+        { "bench-lex", optional_argument, NULL, 'L' },
+        { "bench-parse", optional_argument, NULL, 'P' },
+        { "ll1", no_argument, NULL, 'l' },
+        { "prefetch", required_argument, NULL, 'p' },
+        { "io-stats", no_argument, NULL, 'S' },
+        { "max-depth", required_argument, NULL, 'd' },
+        { "max-nodes", required_argument, NULL, 'n' },
+        { "max-bytes", required_argument, NULL, 'b' },
+        { "max-token", required_argument, NULL, 'k' },
+        { "timeout", required_argument, NULL, 'T' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'o':
+                mode = OUTLINE_MODE;
+                break;
+            case 's':
+                PRINT_SPANS = TRUE;
+                break;
+            case 'r':
+                mode = RUN_MODE;
+                break;
+            case 'J':
+                mode = JIT_MODE;
+                break;
+            case 'K':
+                mode = JIT_CHECK_MODE;
+                break;
+            case 'c':
+                mode = EMIT_C_MODE;
+                break;
+            case 'E':
+                mode = BENCH_EMIT_MODE;
+                break;
+            case 'y':
+                mode = TYPES_MODE;
+                break;
+            case 'D':
+                mode = DIFF_MODE;
+                break;
+            case 'q':
+                mode = QUERY_MODE;
+                if (query_paths == NULL) {
+                    query_paths = (char **)malloc(argc * sizeof(char *));
+                }
+                query_paths[query_num++] = optarg;
+                break;
+            case 't':
+                mode = TOKENS_MODE;
+                break;
+            case 'w':
+                watch_dir = optarg;
+                break;
+            case 'B':
+                debounce_millis = atoi(optarg);
+                if (debounce_millis < 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'j':
+                print_threads = atoi(optarg);
+                if (print_threads <= 0) {
+                    usage(argv[0]);
+                }
+                LEX_THREADS = print_threads;
+                break;
+            case 'L':
+            case 'P':
+                mode = opt == 'L' ? BENCH_LEX_MODE : BENCH_PARSE_MODE;
+                if (optarg != NULL) {
+                    bench_reps = atoi(optarg);
+                }
+                if (bench_reps <= 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'l':
+                TABLE_PARSE = TRUE;
+                break;
+            case 'p':
+                prefetch_depth = atoi(optarg);
+                if (prefetch_depth <= 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'S':
+                io_stats = TRUE;
+                break;
+            case 'd':
+                budget.max_depth = atoi(optarg);
+                break;
+            case 'n':
+                budget.max_nodes = atol(optarg);
+                break;
+            case 'b':
+                budget.max_bytes = atol(optarg);
+                break;
+            case 'k':
+                budget.max_token_size = atol(optarg);
+                break;
+            case 'T':
+                budget.max_millis = atol(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (watch_dir != NULL) {
+        // the files come from the directory
+        if (optind != argc || mode != AST_MODE) {
+            usage(argv[0]);
+        }
+        result_file = stdout;
+        return watch_directory(watch_dir, debounce_millis, print_threads) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (optind == argc || (mode == DIFF_MODE && argc - optind != 2)) {
+        usage(argv[0]);
     }
 
     // write result to stdout
     result_file = stdout;
 
-    // create ast
-    TreeNode *ast = parse();
-    if (!SYNTAX_ERROR) {
-        fprintf(result_file, "[========== AST ==========]\n");
-        print_tree(ast);
+    // read the files in a background thread while parsing
+    int file_num = argc - optind;
+    int status = EXIT_SUCCESS;
+    double start = now();
+    if (!reader_start(&argv[optind], file_num, prefetch_depth)) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
     }
-
-    // free ast
-    free_tree(ast);
-    // close file
-    fclose(src_file);
+    SourceBuffer *source;
+    while ((source = reader_next()) != NULL) {
+        if (source->size < 0) {
+            fflush(result_file);
+            if (source->error == ENOENT) {
+                fprintf(stderr, "File %s not found\n", source->filename);
+            }
+            else {
+                fprintf(stderr, "Can't read %s: %s\n", source->filename, strerror(source->error));
+            }
+            status = EXIT_FAILURE;
+        }
+        else if (mode == DIFF_MODE && status == EXIT_FAILURE) {
+            // the first file failed, so there's nothing to compare with
+        }
+        else if (mode == DIFF_MODE) {
+            SYNTAX_ERROR = FALSE;
+            set_source(source->data, source->size);
+            if (!diff_source()) {
+                status = EXIT_FAILURE;
+            }
+        }
+        else {
+            if (file_num > 1) {
+                fprintf(result_file, "==> %s <==\n", source->filename);
+            }
+            SYNTAX_ERROR = FALSE;
+            set_source(source->data, source->size);
+            if (!run(mode, bench_reps)) {
+                status = EXIT_FAILURE;
+            }
+        }
+        reader_release(source);
+    }
+    reader_stop();
+    free_tree(old_tree);
+    free(query_paths);
+    if (io_stats) {
+        fprintf(stderr, "files: %d, total: %.6f s, waiting for input: %.6f s\n",
+                file_num, now() - start, reader_wait_time());
+    }
+    return status;
 }
\ No newline at end of file
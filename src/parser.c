@@ -1,11 +1,21 @@
 #include "parser.h"
+#include "ll1.h"
+#include "syntax.h"
 #include "scanner.h"
 #include "tree.h"
 #include "util.h"
+#include "budget.h"
 #include <stdlib.h>
+#include <string.h>
 
-// current token
-static TokenType current_token;
+// parse procedure bodies lazily or not
+int LAZY_PARSE = FALSE;
+
+// parse with the table-driven LL(1) parser or not
+int TABLE_PARSE = FALSE;
+
+// threads lexing the source code before parsing (1 scans it while parsing)
+int LEX_THREADS = 1;
 
 // functions
 static TreeNode* program(void);
@@ -21,15 +31,7 @@ static TreeNode* continue_stmt(void);
 static TreeNode* assign_stmt(void);
 static TreeNode* proc_call_stmt(void);
 static TreeNode* expr(void);
-static TreeNode* simple_expr(void);
-static TreeNode* term(void);
-static TreeNode* factor(void);
-
-// print syntax error message
-static void print_syntax_error(char *message) {
-    SYNTAX_ERROR = TRUE;
-    fprintf(result_file, "Syntax error at line %d: %s", line_idx, message);
-}
+static TreeNode* binary_expr(int min_power);
 
 // check syntax error
 #define CHECK_SYNTAX_ERROR \
@@ -37,22 +39,30 @@ static void print_syntax_error(char *message) {
         return NULL;       \
     }
 
+// enter a nested construct, or give up if it's nested too deep
+#define ENTER_NESTING          \
+    if (!budget_enter()) {     \
+        return NULL;           \
+    }
+
+// leave a nested construct
+#define LEAVE_NESTING budget_leave(1);
+
 // match the expected token
 static void match(TokenType expected) {
     if (SYNTAX_ERROR) {
         return;
     }
     else if (current_token == expected) {
-        current_token = get_next_token();
+        advance_token();
     }
     else {
         // syntax error
-        SYNTAX_ERROR = TRUE;
-        print_syntax_error("Unexpected Token -> ");
-        print_token(current_token, lexeme);
+        unexpected_token();
     }
 }
 
+
 // main program
 TreeNode* program(void) {
     CHECK_SYNTAX_ERROR
@@ -74,10 +84,44 @@ TreeNode* program(void) {
         }
     }
     // match stmts
-    p->sibling = stmts();
+    if (p == NULL) {
+        t = stmts();
+    }
+    else {
+        p->sibling = stmts();
+    }
     return t;
 }
 
+// skip from "begin" to the matching "end" of a procedure body
+// by balancing if/repeat ... end/until, without building any node
+static LazyBody* skip_proc_body(void) {
+    LazyBody *body = (LazyBody *)budget_malloc(sizeof(LazyBody));
+    if (body == NULL) {
+        return NULL;
+    }
+    body->start = token_span.start + token_span.length;
+    current_token = get_next_token();
+    int depth = 0;
+    while (!SYNTAX_ERROR && current_token != ENDFILE_TOKEN) {
+        if (current_token == IF_TOKEN || current_token == REPEAT_TOKEN) {
+            depth += 1;
+        }
+        else if (current_token == END_TOKEN || current_token == UNTIL_TOKEN) {
+            if (depth > 0) {
+                depth -= 1;
+            }
+            else if (current_token == END_TOKEN) {
+                break;
+            }
+            // a stray "until" is reported when the body is parsed
+        }
+        current_token = get_next_token();
+    }
+    body->end = token_span.start;
+    return body;
+}
+
 TreeNode* proc_def(void) {
     CHECK_SYNTAX_ERROR
     TreeNode *t = new_proc_node();
@@ -91,19 +135,27 @@ TreeNode* proc_def(void) {
         }
         t->child[0] = p;
         match(ID_TOKEN);
-        // match "begin"
-        match(BEGIN_TOKEN);
-        // match stmts
-        t->child[1] = stmts();
+        finish_node(p);
+        if (LAZY_PARSE && current_token == BEGIN_TOKEN) {
+            // only find where the body is
+            t->attr.lazy = skip_proc_body();
+        }
+        else {
+            // match "begin"
+            match(BEGIN_TOKEN);
+            // match stmts
+            t->child[1] = stmts();
+        }
         // match "end"
         match(END_TOKEN);
     }
-    return t;
+    return finish_node(t);
 }
 
 // statements
 TreeNode* stmts(void) {
     CHECK_SYNTAX_ERROR
+    ENTER_NESTING
     // match one statement first
     TreeNode *t = NULL;
     TreeNode *p = NULL;
@@ -122,6 +174,7 @@ TreeNode* stmts(void) {
         }
         match(SEMI_TOKEN);
     }
+    LEAVE_NESTING
     return t;
 }
 
@@ -156,8 +209,7 @@ TreeNode* stmt(void) {
             break;
         default:
             // syntax error
-            print_syntax_error("Unexpected Token -> ");
-            print_token(current_token, lexeme);
+            unexpected_token();
             current_token = get_next_token();
             break;
     }
@@ -173,7 +225,7 @@ TreeNode* read_stmt(void) {
         t->attr.name = copy_string(lexeme);
     }
     match(ID_TOKEN);
-    return t;
+    return finish_node(t);
 }
 
 // write statement
@@ -184,7 +236,7 @@ TreeNode* write_stmt(void) {
     if (t != NULL) {
         t->child[0] = expr();
     }
-    return t;
+    return finish_node(t);
 }
 
 // if statement
@@ -206,7 +258,7 @@ static TreeNode* if_stmt(void) {
         }
     }
     match(END_TOKEN);
-    return t;
+    return finish_node(t);
 }
 
 // repeat statement
@@ -221,7 +273,7 @@ TreeNode* repeat_stmt(void) {
     if (t != NULL) {
         t->child[1] = expr();
     }
-    return t;
+    return finish_node(t);
 }
 
 // break statement
@@ -231,7 +283,7 @@ TreeNode* break_stmt(void) {
     if (t != NULL) {
         match(BREAK_TOKEN);
     }
-    return t;
+    return finish_node(t);
 }
 
 // continue statement
@@ -241,7 +293,7 @@ TreeNode* continue_stmt(void) {
     if (t != NULL) {
         match(CONTINUE_TOKEN);
     }
-    return t;
+    return finish_node(t);
 }
 
 // assign statement
@@ -256,7 +308,7 @@ TreeNode* assign_stmt(void) {
     if (t != NULL) {
         t->child[0] = expr();
     }
-    return t;
+    return finish_node(t);
 }
 
 TreeNode* proc_call_stmt(void) {
@@ -269,76 +321,71 @@ TreeNode* proc_call_stmt(void) {
         }
         match(ID_TOKEN);
     }
-    return t;
+    return finish_node(t);
 }
 
-// expression
-TreeNode* expr(void) {
-    CHECK_SYNTAX_ERROR
-    TreeNode *t = simple_expr();
-    if (current_token == LT_TOKEN || current_token == EQ_TOKEN) {
-        TreeNode *p = new_expr_node(OP_EXPR);
-        if (p != NULL) {
-            p->child[0] = t;
-            p->attr.op = current_token;
-            t = p;
-            match(current_token);
-            t->child[1] = simple_expr();
-        }
-    }
-    return t;
-}
+// associativity of a binary operator
+typedef enum {
+    // a op b op c is an error
+    NON_ASSOC,
+    // a op b op c is (a op b) op c
+    LEFT_ASSOC,
+    // a op b op c is a op (b op c)
+    RIGHT_ASSOC
+} Associativity;
 
-// simple expression
-TreeNode* simple_expr(void) {
-    CHECK_SYNTAX_ERROR
-    TreeNode *t = term();
-    while (current_token == ADD_TOKEN || current_token == SUB_TOKEN) {
-        TreeNode *p = new_expr_node(OP_EXPR);
-        if (p != NULL) {
-            p->child[0] = t;
-            p->attr.op = current_token;
-            t = p;
-            match(current_token);
-            t->child[1] = term();
-        }
-    }
-    return t;
-}
+// a binary operator
+typedef struct {
+    // binding power, higher binds tighter; 0 if the token is no operator
+    unsigned char power;
+    Associativity assoc;
+} Operator;
 
-// term
-TreeNode* term(void) {
+// binary operators by token
+static const Operator operators[ERROR_TOKEN + 1] = {
+    [LT_TOKEN] = { 10, NON_ASSOC },
+    [EQ_TOKEN] = { 10, NON_ASSOC },
+    [ADD_TOKEN] = { 20, LEFT_ASSOC },
+    [SUB_TOKEN] = { 20, LEFT_ASSOC },
+    [MUL_TOKEN] = { 30, LEFT_ASSOC },
+    [DIV_TOKEN] = { 30, LEFT_ASSOC }
+};
+
+// expression
+TreeNode* expr(void) {
     CHECK_SYNTAX_ERROR
-    TreeNode* t = factor();
-    while (current_token == MUL_TOKEN || current_token == DIV_TOKEN) {
-        TreeNode *p = new_expr_node(OP_EXPR);
-        if (p != NULL) {
-            p->child[0] = t;
-            p->attr.op = current_token;
-            t = p;
-            match(current_token);
-            p->child[1] = factor();
-        }
-    }
+    ENTER_NESTING
+    TreeNode *t = binary_expr(0);
+    LEAVE_NESTING
     return t;
 }
 
-// factor
-TreeNode* factor(void) {
+// operand followed by operators with power min_power or more, and their
+// right operands (precedence climbing: one call per operand)
+TreeNode* binary_expr(int min_power) {
     CHECK_SYNTAX_ERROR
     TreeNode* t = NULL;
+    // match the operand
     switch (current_token) {
-        case LPAREN_TOKEN:
+        case LPAREN_TOKEN: {
+            // the span includes the parentheses
+            long start = token_span.start;
             match(LPAREN_TOKEN);
             t = expr();
             match(RPAREN_TOKEN);
+            if (t != NULL) {
+                t->span.start = start;
+                finish_node(t);
+            }
             break;
+        }
         case ID_TOKEN:
             t = new_expr_node(ID_EXPR);
             if (t != NULL) {
                 t->attr.name = copy_string(lexeme);
             }
             match(ID_TOKEN);
+            finish_node(t);
             break;
         case INTEGER_TOKEN:
             t = new_expr_node(INTEGER_EXPR);
@@ -346,6 +393,7 @@ TreeNode* factor(void) {
                 t->attr.integer_val = atoi(lexeme);
             }
             match(INTEGER_TOKEN);
+            finish_node(t);
             break;
         case FLOAT_TOKEN:
             t = new_expr_node(FLOAT_EXPR);
@@ -353,24 +401,111 @@ TreeNode* factor(void) {
                 t->attr.float_val = atof(lexeme);
             }
             match(FLOAT_TOKEN);
+            finish_node(t);
             break;
         default:
             // syntax error
-            print_syntax_error("Unexpected Token -> ");
-            print_token(current_token, lexeme);
+            unexpected_token();
             current_token = get_next_token();
+            return t;
+    }
+    // match operators binding at least as tight as min_power
+    // (each chained operator nests the tree built so far one level deeper;
+    // like one rule per precedence level, a chain ends at a looser operator)
+    int levels = 0;
+    int chain_power = 0;
+    // power of a non-associative operator already matched
+    int closed_power = 0;
+    while (!SYNTAX_ERROR) {
+        const Operator *op = &operators[current_token];
+        if (op->power == 0 || op->power < min_power || op->power == closed_power) {
             break;
+        }
+        if (op->power < chain_power) {
+            budget_leave(levels);
+            levels = 0;
+        }
+        chain_power = op->power;
+        if (op->assoc == NON_ASSOC) {
+            closed_power = op->power;
+        }
+        else {
+            if (!budget_enter()) {
+                break;
+            }
+            levels += 1;
+        }
+        TreeNode *p = new_op_node(t);
+        if (p != NULL) {
+            t = p;
+            match(current_token);
+            t->child[1] = binary_expr(op->assoc == RIGHT_ASSOC ? op->power : op->power + 1);
+            finish_node(t);
+        }
     }
+    budget_leave(levels);
     return t;
 }
 
-// parse and return a new syntax tree
-TreeNode* parse(void) {
+// get the body of a procedure, parsing it first if it was skipped
+TreeNode* proc_body(TreeNode *t) {
+    if (t->attr.lazy != NULL) {
+        LazyBody *body = t->attr.lazy;
+        t->attr.lazy = NULL;
+        // save the scanner state
+        long saved_offset = scanner_offset();
+        SourceSpan saved_span = token_span;
+        TokenType saved_token = current_token;
+        char saved_lexeme[MAX_TOKEN_SIZE + 1];
+        strcpy(saved_lexeme, lexeme);
+        // parse stmts up to "end"
+        scanner_seek(body->start);
+        current_token = get_next_token();
+        t->child[1] = stmts();
+        if (current_token != END_TOKEN) {
+            match(END_TOKEN);
+        }
+        free(body);
+        // continue from where the scanner was
+        scanner_seek(saved_offset);
+        token_span = saved_span;
+        current_token = saved_token;
+        strcpy(lexeme, saved_lexeme);
+    }
+    return t->child[1];
+}
+
+// parse the tokens with recursive descent
+static TreeNode* descent_parse(void) {
+    budget_start();
     current_token = get_next_token();
     TreeNode *t = program();
     if (!SYNTAX_ERROR && current_token != ENDFILE_TOKEN) {
         // syntax error
-        print_syntax_error("Code ends before file!\n");
+        syntax_error("Code ends before file!");
+    }
+    return t;
+}
+
+// parse and return a new syntax tree
+TreeNode* parse(void) {
+    TokenArray tokens = { NULL, 0, 0 };
+    if (LEX_THREADS > 1) {
+        lex_parallel(LEX_THREADS, &tokens);
+        use_token_array(&tokens);
+    }
+    TreeNode *t;
+    if (TABLE_PARSE && !LAZY_PARSE) {
+        // the table-driven parser always parses procedure bodies
+        t = ll1_parse();
+    }
+    else {
+        t = descent_parse();
+    }
+    if (tokens.tokens != NULL) {
+        // bodies parsed later by proc_body scan the source code again
+        use_token_array(NULL);
+        free(tokens.tokens);
     }
     return t;
 }
\ No newline at end of file
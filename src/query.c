@@ -0,0 +1,364 @@
+#include "query.h"
+#include "scanner.h"
+#include "symtab.h"
+#include "tree.h"
+#include <stdlib.h>
+#include <string.h>
+
+// kinds of nodes a query step can ask for
+typedef enum {
+    PROC_KIND,
+    // one kind for each StmtType, then each ExprType
+    FIRST_STMT_KIND,
+    FIRST_EXPR_KIND = FIRST_STMT_KIND + PROC_CALL_STMT + 1,
+    // the number of kinds
+    KIND_NUM = FIRST_EXPR_KIND + OP_EXPR + 1,
+    // any kind, "*"
+    ANY_KIND = KIND_NUM
+} NodeKind;
+
+// names of kinds in queries, in NodeKind order
+static const char *kind_names[KIND_NUM + 1] = {
+    "proc",
+    "read", "write", "if", "repeat", "break", "continue", "assign", "call",
+    "id", "int", "float", "op",
+    "*"
+};
+
+// kind of a node
+static NodeKind kind_of(TreeNode *t) {
+    if (t->node_type == STMT_NODE) {
+        return FIRST_STMT_KIND + t->type.stmt_type;
+    }
+    else if (t->node_type == EXPR_NODE) {
+        return FIRST_EXPR_KIND + t->type.expr_type;
+    }
+    return PROC_KIND;
+}
+
+// name of a node for "kind[name]", or NULL
+static const char* name_of(TreeNode *t) {
+    if (t->node_type == PROC_NODE) {
+        return t->child[0] != NULL ? t->child[0]->attr.name : NULL;
+    }
+    else if (t->node_type == STMT_NODE) {
+        if (t->type.stmt_type == READ_STMT || t->type.stmt_type == ASSIGN_STMT
+            || t->type.stmt_type == PROC_CALL_STMT) {
+            return t->attr.name;
+        }
+    }
+    else if (t->node_type == EXPR_NODE) {
+        if (t->type.expr_type == ID_EXPR) {
+            return t->attr.name;
+        }
+        else if (t->type.expr_type == OP_EXPR) {
+            switch (t->attr.op) {
+                case EQ_TOKEN: return "=";
+                case LT_TOKEN: return "<";
+                case ADD_TOKEN: return "+";
+                case SUB_TOKEN: return "-";
+                case MUL_TOKEN: return "*";
+                case DIV_TOKEN: return "/";
+                default: return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+// growing list of preorder numbers, always in increasing order
+typedef struct {
+    int *ids;
+    int num;
+    int capacity;
+} IdList;
+
+// append a preorder number to a list
+static void add_id(IdList *list, int id) {
+    if (list->num == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->ids = (int *)realloc(list->ids, list->capacity * sizeof(int));
+    }
+    list->ids[list->num] = id;
+    list->num += 1;
+}
+
+struct QueryIndex {
+    // the number of nodes
+    int num;
+    // nodes by preorder number
+    TreeNode **nodes;
+    // preorder number of the last node in each subtree, so a node b is
+    // below a if a < b <= last[a]
+    int *last;
+    // preorder number of each parent, -1 at the top
+    int *parent;
+    // nodes of each kind
+    IdList by_kind[KIND_NUM];
+    // nodes with each name, the value of a symbol is its list
+    SymTab names;
+    IdList *by_name;
+    int name_num;
+    int name_capacity;
+    // buffers of the steps of a query
+    int *current;
+    int *next;
+    int *candidates;
+    // nodes marked with the stamp are parents wanted by a "/" step
+    int *mark;
+    int stamp;
+    TreeNode **results;
+};
+
+// add a list of siblings below a parent to the index
+// (loops over siblings, so only nesting uses the stack)
+static void add_nodes(QueryIndex *index, TreeNode *t, int parent) {
+    while (t != NULL) {
+        int id = index->num;
+        if (id % 1024 == 0) {
+            int capacity = id + 1024;
+            index->nodes = (TreeNode **)realloc(index->nodes, capacity * sizeof(TreeNode *));
+            index->last = (int *)realloc(index->last, capacity * sizeof(int));
+            index->parent = (int *)realloc(index->parent, capacity * sizeof(int));
+        }
+        index->num += 1;
+        index->nodes[id] = t;
+        index->parent[id] = parent;
+        add_id(&index->by_kind[kind_of(t)], id);
+        const char *name = name_of(t);
+        if (name != NULL) {
+            Symbol *s = st_lookup(&index->names, name);
+            if (s == NULL) {
+                if (index->name_num == index->name_capacity) {
+                    index->name_capacity = index->name_capacity ? index->name_capacity * 2 : 64;
+                    index->by_name = (IdList *)realloc(index->by_name,
+                                                       index->name_capacity * sizeof(IdList));
+                }
+                s = st_insert(&index->names, name);
+                s->value = index->name_num;
+                index->by_name[s->value] = (IdList){ NULL, 0, 0 };
+                index->name_num += 1;
+            }
+            add_id(&index->by_name[s->value], id);
+        }
+        for (int i = 0; i < MAX_CHILDREN; i++) {
+            add_nodes(index, t->child[i], id);
+        }
+        index->last[id] = index->num - 1;
+        t = t->sibling;
+    }
+}
+
+// index the nodes of a tree by kind, by name and by preorder number
+QueryIndex* query_index(TreeNode *t) {
+    QueryIndex *index = (QueryIndex *)calloc(1, sizeof(QueryIndex));
+    st_init(&index->names);
+    add_nodes(index, t, -1);
+    int size = index->num + 1;
+    index->current = (int *)malloc(size * sizeof(int));
+    index->next = (int *)malloc(size * sizeof(int));
+    index->candidates = (int *)malloc(size * sizeof(int));
+    index->mark = (int *)calloc(size, sizeof(int));
+    index->results = (TreeNode **)malloc(size * sizeof(TreeNode *));
+    return index;
+}
+
+// free memory of the indexes, but not the tree
+void query_free(QueryIndex *index) {
+    if (index == NULL) {
+        return;
+    }
+    for (int i = 0; i < KIND_NUM; i++) {
+        free(index->by_kind[i].ids);
+    }
+    for (int i = 0; i < index->name_num; i++) {
+        free(index->by_name[i].ids);
+    }
+    free(index->by_name);
+    st_free(&index->names);
+    free(index->nodes);
+    free(index->last);
+    free(index->parent);
+    free(index->current);
+    free(index->next);
+    free(index->candidates);
+    free(index->mark);
+    free(index->results);
+    free(index);
+}
+
+// the most steps in a path
+#define MAX_STEPS 32
+
+// one step of a path
+typedef struct {
+    // TRUE for "/", FALSE for "//"
+    int is_child;
+    NodeKind kind;
+    // "name" of "kind[name]", or empty
+    char name[MAX_TOKEN_SIZE + 1];
+} Step;
+
+// print a query error about a position in the path and return -1
+static int query_error(const char *path, const char *at, const char *message) {
+    fprintf(result_file, "Query error at column %d: %s\n", (int)(at - path) + 1, message);
+    return -1;
+}
+
+// split a path into steps and return how many there are, or -1
+static int parse_path(const char *path, Step *steps) {
+    const char *p = path;
+    int step_num = 0;
+    while (*p != '\0') {
+        if (step_num == MAX_STEPS) {
+            return query_error(path, p, "Too many steps");
+        }
+        Step *step = &steps[step_num];
+        // axis, the first step is below the top without any
+        step->is_child = FALSE;
+        if (p[0] == '/' && p[1] == '/') {
+            p += 2;
+        }
+        else if (p[0] == '/') {
+            step->is_child = TRUE;
+            p += 1;
+        }
+        else if (step_num > 0) {
+            return query_error(path, p, "Expected / or //");
+        }
+        // kind
+        const char *word = p;
+        if (*p == '*') {
+            p += 1;
+        }
+        else {
+            while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')) {
+                p += 1;
+            }
+        }
+        int kind = 0;
+        while (kind <= ANY_KIND && (strncmp(kind_names[kind], word, p - word)
+                                    || kind_names[kind][p - word] != '\0')) {
+            kind += 1;
+        }
+        if (p == word || kind > ANY_KIND) {
+            return query_error(path, word, "Unknown kind");
+        }
+        step->kind = kind;
+        // name
+        step->name[0] = '\0';
+        if (*p == '[') {
+            const char *name = p + 1;
+            p = strchr(name, ']');
+            if (p == NULL) {
+                return query_error(path, name - 1, "Missing ]");
+            }
+            if (p == name || p - name > MAX_TOKEN_SIZE) {
+                return query_error(path, name, "Bad name");
+            }
+            memcpy(step->name, name, p - name);
+            step->name[p - name] = '\0';
+            p += 1;
+        }
+        step_num += 1;
+    }
+    if (step_num == 0) {
+        return query_error(path, p, "Empty path");
+    }
+    return step_num;
+}
+
+// put the nodes a step asks for into candidates and return how many
+// (takes time in the size of the smallest index the step can use)
+static int find_candidates(QueryIndex *index, Step *step) {
+    int num = 0;
+    if (step->name[0] != '\0') {
+        Symbol *s = st_lookup(&index->names, step->name);
+        if (s != NULL) {
+            IdList *list = &index->by_name[s->value];
+            for (int i = 0; i < list->num; i++) {
+                int id = list->ids[i];
+                if (step->kind == ANY_KIND || kind_of(index->nodes[id]) == step->kind) {
+                    index->candidates[num++] = id;
+                }
+            }
+        }
+    }
+    else if (step->kind == ANY_KIND) {
+        for (int id = 0; id < index->num; id++) {
+            index->candidates[num++] = id;
+        }
+    }
+    else {
+        IdList *list = &index->by_kind[step->kind];
+        if (list->num > 0) {
+            memcpy(index->candidates, list->ids, list->num * sizeof(int));
+        }
+        num = list->num;
+    }
+    return num;
+}
+
+// find the nodes matching a path, e.g. "repeat//float" or "assign[fact]",
+// and return how many there are, or -1 if the path is not valid
+int query_find(QueryIndex *index, const char *path, TreeNode ***results) {
+    Step steps[MAX_STEPS];
+    int step_num = parse_path(path, steps);
+    if (step_num < 0) {
+        return -1;
+    }
+    // the first step: a "/" keeps top-level nodes only
+    int num = find_candidates(index, &steps[0]);
+    int current_num = 0;
+    for (int i = 0; i < num; i++) {
+        int id = index->candidates[i];
+        if (!steps[0].is_child || index->parent[id] < 0) {
+            index->current[current_num++] = id;
+        }
+    }
+    // each next step keeps its candidates below the current nodes
+    for (int k = 1; k < step_num && current_num > 0; k++) {
+        num = find_candidates(index, &steps[k]);
+        int next_num = 0;
+        if (steps[k].is_child) {
+            // parent is a current node
+            index->stamp += 1;
+            for (int i = 0; i < current_num; i++) {
+                index->mark[index->current[i]] = index->stamp;
+            }
+            for (int i = 0; i < num; i++) {
+                int id = index->candidates[i];
+                if (index->parent[id] >= 0 && index->mark[index->parent[id]] == index->stamp) {
+                    index->next[next_num++] = id;
+                }
+            }
+        }
+        else {
+            // both lists are in preorder, so merge them: a candidate is below
+            // a current node iff some current node before it ends after it
+            int i = 0;
+            int end = -1;
+            for (int j = 0; j < num; j++) {
+                int id = index->candidates[j];
+                while (i < current_num && index->current[i] < id) {
+                    if (index->last[index->current[i]] > end) {
+                        end = index->last[index->current[i]];
+                    }
+                    i += 1;
+                }
+                if (id <= end) {
+                    index->next[next_num++] = id;
+                }
+            }
+        }
+        int *swap = index->current;
+        index->current = index->next;
+        index->next = swap;
+        current_num = next_num;
+    }
+    for (int i = 0; i < current_num; i++) {
+        index->results[i] = index->nodes[index->current[i]];
+    }
+    *results = index->results;
+    return current_num;
+}
\ No newline at end of file
@@ -0,0 +1,260 @@
+#define _GNU_SOURCE
+#include "reader.h"
+#include "global.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// files to read
+static char **filenames;
+static int file_num;
+// file descriptors opened ahead of time, -1 if not opened yet
+static int *fds;
+// errno of each file that couldn't be opened, 0 if none
+static int *open_errors;
+
+// buffers, at most depth of them in memory
+static SourceBuffer *buffers;
+static int depth;
+// buffers not in use, as a stack
+static SourceBuffer **free_buffers;
+static int free_num;
+// buffers read and not yet taken, as a ring in file order
+static SourceBuffer **ready_buffers;
+static int ready_head;
+static int ready_num;
+// the number of files taken by reader_next
+static int taken_num;
+
+static pthread_t thread;
+// the reader thread is running, otherwise reader_next reads each file
+static int thread_started;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+// signaled when a buffer is released
+static pthread_cond_t buffer_freed = PTHREAD_COND_INITIALIZER;
+// signaled when a file has been read
+static pthread_cond_t buffer_ready = PTHREAD_COND_INITIALIZER;
+
+// time spent waiting in reader_next
+static double wait_time;
+
+// current time in seconds
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// open a file and ask the kernel to start reading it into the page cache
+static void open_ahead(int i) {
+    if (fds[i] == -1) {
+        fds[i] = open(filenames[i], O_RDONLY);
+        open_errors[i] = fds[i] == -1 ? errno : 0;
+        if (fds[i] != -1) {
+            posix_fadvise(fds[i], 0, 0, POSIX_FADV_WILLNEED);
+            posix_fadvise(fds[i], 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+    }
+}
+
+// give up reading a file into a buffer because of an errno
+static void read_failed(SourceBuffer *buffer, int error) {
+    buffer->size = -1;
+    buffer->error = error;
+}
+
+// read a whole file into a buffer, growing it if needed
+// (open_error is the errno of opening it if fd is -1)
+static void read_file(int fd, int open_error, SourceBuffer *buffer) {
+    struct stat st;
+    if (fd == -1) {
+        read_failed(buffer, open_error);
+        return;
+    }
+    if (fstat(fd, &st) == -1) {
+        read_failed(buffer, errno);
+        return;
+    }
+    // the size is only a hint, as the file may still be growing
+    long size = 0;
+    long capacity = (st.st_size > 0 ? st.st_size : 4096) + 1;
+    if (buffer->capacity < capacity) {
+        free(buffer->data);
+        buffer->data = (char *)malloc(capacity);
+        buffer->capacity = buffer->data != NULL ? capacity : 0;
+        if (buffer->data == NULL) {
+            read_failed(buffer, ENOMEM);
+            return;
+        }
+    }
+    for (;;) {
+        if (size == buffer->capacity) {
+            char *data = (char *)realloc(buffer->data, buffer->capacity * 2);
+            if (data == NULL) {
+                read_failed(buffer, ENOMEM);
+                return;
+            }
+            buffer->data = data;
+            buffer->capacity *= 2;
+        }
+        ssize_t n = read(fd, buffer->data + size, buffer->capacity - size);
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // a part of the file isn't worth parsing
+            read_failed(buffer, errno);
+            return;
+        }
+        size += n;
+    }
+    buffer->size = size;
+    buffer->error = 0;
+}
+
+// read a whole file into a buffer in the calling thread
+void read_source(const char *filename, SourceBuffer *buffer) {
+    int fd = open(filename, O_RDONLY);
+    read_file(fd, errno, buffer);
+    if (fd != -1) {
+        close(fd);
+    }
+}
+
+// read file i of the list into a buffer and close it
+static void read_listed_file(int i, SourceBuffer *buffer) {
+    open_ahead(i);
+    buffer->filename = filenames[i];
+    read_file(fds[i], open_errors[i], buffer);
+    if (fds[i] != -1) {
+        close(fds[i]);
+    }
+}
+
+// reader thread: read the files in order, a few files ahead of the parser
+static void* reader_main(void *arg) {
+    (void)arg;
+    for (int i = 0; i < file_num; i++) {
+        // hint the files that will be read after this one
+        for (int j = i; j < file_num && j <= i + depth; j++) {
+            open_ahead(j);
+        }
+        // wait for a free buffer
+        pthread_mutex_lock(&lock);
+        while (free_num == 0) {
+            pthread_cond_wait(&buffer_freed, &lock);
+        }
+        SourceBuffer *buffer = free_buffers[--free_num];
+        pthread_mutex_unlock(&lock);
+
+        read_listed_file(i, buffer);
+
+        // hand the buffer to the parser
+        pthread_mutex_lock(&lock);
+        ready_buffers[(ready_head + ready_num) % depth] = buffer;
+        ready_num += 1;
+        pthread_cond_signal(&buffer_ready);
+        pthread_mutex_unlock(&lock);
+    }
+    return NULL;
+}
+
+// free the lists of the reader
+static void free_lists(void) {
+    free(buffers);
+    free(free_buffers);
+    free(ready_buffers);
+    free(fds);
+    free(open_errors);
+}
+
+// start reading the files in order in a background thread,
+// keeping at most depth files in memory
+// (returns FALSE if there's no memory for the lists of files and buffers)
+int reader_start(char **names, int num, int max_depth) {
+    filenames = names;
+    file_num = num;
+    depth = max_depth;
+    fds = (int *)malloc(file_num * sizeof(int));
+    open_errors = (int *)calloc(file_num, sizeof(int));
+    buffers = (SourceBuffer *)calloc(depth, sizeof(SourceBuffer));
+    free_buffers = (SourceBuffer **)malloc(depth * sizeof(SourceBuffer *));
+    ready_buffers = (SourceBuffer **)malloc(depth * sizeof(SourceBuffer *));
+    if (fds == NULL || open_errors == NULL || buffers == NULL
+        || free_buffers == NULL || ready_buffers == NULL) {
+        free_lists();
+        return FALSE;
+    }
+    for (int i = 0; i < file_num; i++) {
+        fds[i] = -1;
+    }
+    for (int i = 0; i < depth; i++) {
+        free_buffers[i] = &buffers[i];
+    }
+    free_num = depth;
+    ready_head = 0;
+    ready_num = 0;
+    taken_num = 0;
+    wait_time = 0;
+    // without a thread, each file is read when it's asked for
+    thread_started = !pthread_create(&thread, NULL, reader_main, NULL);
+    return TRUE;
+}
+
+// wait for the next file, or return NULL after the last one
+SourceBuffer* reader_next(void) {
+    if (taken_num == file_num) {
+        return NULL;
+    }
+    double start = now();
+    if (!thread_started) {
+        // the parser has released the buffer of the last file
+        SourceBuffer *buffer = free_buffers[--free_num];
+        read_listed_file(taken_num, buffer);
+        taken_num += 1;
+        wait_time += now() - start;
+        return buffer;
+    }
+    pthread_mutex_lock(&lock);
+    while (ready_num == 0) {
+        pthread_cond_wait(&buffer_ready, &lock);
+    }
+    SourceBuffer *buffer = ready_buffers[ready_head];
+    ready_head = (ready_head + 1) % depth;
+    ready_num -= 1;
+    pthread_mutex_unlock(&lock);
+    taken_num += 1;
+    wait_time += now() - start;
+    return buffer;
+}
+
+// give a buffer back to the reader once its file is done with
+void reader_release(SourceBuffer *buffer) {
+    pthread_mutex_lock(&lock);
+    free_buffers[free_num++] = buffer;
+    pthread_cond_signal(&buffer_freed);
+    pthread_mutex_unlock(&lock);
+}
+
+// wait for the reader thread and free the buffers
+void reader_stop(void) {
+    if (thread_started) {
+        pthread_join(thread, NULL);
+    }
+    for (int i = 0; i < depth; i++) {
+        free(buffers[i].data);
+    }
+    free_lists();
+}
+
+// seconds spent in reader_next waiting for a file to be read
+double reader_wait_time(void) {
+    return wait_time;
+}
\ No newline at end of file
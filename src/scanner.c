@@ -1,6 +1,9 @@
 #include "scanner.h"
+#include "budget.h"
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 
 // states in scanner DFA
 typedef enum {
@@ -10,53 +13,286 @@ typedef enum {
     IN_ID,
     IN_INTEGER,
     IN_FLOAT,
-    DONE
+    DONE,
+    // the number of DFA states
+    STATE_NUM
 } StateType;
 
+// character classes in scanner DFA
+typedef enum {
+    OTHER_CLASS,    // any character without its own class
+    SPACE_CLASS,    // ' ', '\t', '\n'
+    LBRACE_CLASS,   // {
+    RBRACE_CLASS,   // }
+    COLON_CLASS,    // :
+    LETTER_CLASS,   // a-z, A-Z
+    DIGIT_CLASS,    // 0-9
+    DOT_CLASS,      // .
+    EQ_CLASS,       // =
+    LT_CLASS,       // <
+    ADD_CLASS,      // +
+    SUB_CLASS,      // -
+    MUL_CLASS,      // *
+    DIV_CLASS,      // /
+    LPAREN_CLASS,   // (
+    RPAREN_CLASS,   // )
+    SEMI_CLASS,     // ;
+    EOF_CLASS,      // end of file
+    // the number of character classes
+    CLASS_NUM
+} CharClass;
+
+// class of each character
+static const unsigned char char_class[256] = {
+    [' '] = SPACE_CLASS,
+    ['\t'] = SPACE_CLASS,
+    ['\n'] = SPACE_CLASS,
+    ['{'] = LBRACE_CLASS,
+    ['}'] = RBRACE_CLASS,
+    [':'] = COLON_CLASS,
+    ['a' ... 'z'] = LETTER_CLASS,
+    ['A' ... 'Z'] = LETTER_CLASS,
+    ['0' ... '9'] = DIGIT_CLASS,
+    ['.'] = DOT_CLASS,
+    ['='] = EQ_CLASS,
+    ['<'] = LT_CLASS,
+    ['+'] = ADD_CLASS,
+    ['-'] = SUB_CLASS,
+    ['*'] = MUL_CLASS,
+    ['/'] = DIV_CLASS,
+    ['('] = LPAREN_CLASS,
+    [')'] = RPAREN_CLASS,
+    [';'] = SEMI_CLASS
+};
+
+// flags of a DFA transition
+#define SAVE_CHAR 1     // save current char to lexeme
+#define CANCEL_CHAR 2   // push current char back to the input
+
+// a DFA transition
+typedef struct {
+    // next state
+    unsigned char next_state;
+    // SAVE_CHAR and/or CANCEL_CHAR
+    unsigned char flags;
+    // token accepted when next state is DONE
+    unsigned char token;
+    // pad to 4 bytes so a row index is a shift
+    unsigned char unused;
+} Transition;
+
+// go to state s and save current char
+#define GOTO(s) { s, SAVE_CHAR, ERROR_TOKEN }
+// go to state s and drop current char
+#define SKIP(s) { s, 0, ERROR_TOKEN }
+// accept token t including current char
+#define ACCEPT(t) { DONE, SAVE_CHAR, t }
+// accept token t and push current char back
+#define ACCEPT_BEFORE(t) { DONE, CANCEL_CHAR, t }
+// every class of a row
+#define ALL_CLASSES 0 ... CLASS_NUM - 1
+
+// transition matrix: state x character class -> transition
+static const Transition transitions[STATE_NUM][CLASS_NUM] = {
+    // ============= [Start] =============
+    [START] = {
+        [OTHER_CLASS] = ACCEPT(ERROR_TOKEN),
+        [SPACE_CLASS] = SKIP(START),
+        [LBRACE_CLASS] = SKIP(IN_COMMENT),
+        [RBRACE_CLASS] = ACCEPT(ERROR_TOKEN),
+        [COLON_CLASS] = GOTO(IN_ASSIGN),
+        [LETTER_CLASS] = GOTO(IN_ID),
+        [DIGIT_CLASS] = GOTO(IN_INTEGER),
+        [DOT_CLASS] = ACCEPT(ERROR_TOKEN),
+        [EQ_CLASS] = ACCEPT(EQ_TOKEN),
+        [LT_CLASS] = ACCEPT(LT_TOKEN),
+        [ADD_CLASS] = ACCEPT(ADD_TOKEN),
+        [SUB_CLASS] = ACCEPT(SUB_TOKEN),
+        [MUL_CLASS] = ACCEPT(MUL_TOKEN),
+        [DIV_CLASS] = ACCEPT(DIV_TOKEN),
+        [LPAREN_CLASS] = ACCEPT(LPAREN_TOKEN),
+        [RPAREN_CLASS] = ACCEPT(RPAREN_TOKEN),
+        [SEMI_CLASS] = ACCEPT(SEMI_TOKEN),
+        [EOF_CLASS] = { DONE, 0, ENDFILE_TOKEN }
+    },
+    // ============= [In Comment] =============
+    [IN_COMMENT] = {
+        [ALL_CLASSES] = SKIP(IN_COMMENT),
+        [RBRACE_CLASS] = SKIP(START),
+        [EOF_CLASS] = { DONE, 0, ENDFILE_TOKEN }
+    },
+    // ============= [In Assign] =============
+    [IN_ASSIGN] = {
+        // only ':=' is valid
+        [ALL_CLASSES] = ACCEPT_BEFORE(ERROR_TOKEN),
+        [EQ_CLASS] = ACCEPT(ASSIGN_TOKEN)
+    },
+    // ============= [In ID] =============
+    [IN_ID] = {
+        [ALL_CLASSES] = ACCEPT_BEFORE(ID_TOKEN),
+        [LETTER_CLASS] = GOTO(IN_ID),
+        [DIGIT_CLASS] = GOTO(IN_ID)
+    },
+    // ============= [In Integer] =============
+    [IN_INTEGER] = {
+        [ALL_CLASSES] = ACCEPT_BEFORE(INTEGER_TOKEN),
+        [DIGIT_CLASS] = GOTO(IN_INTEGER),
+        [DOT_CLASS] = GOTO(IN_FLOAT)
+    },
+    // ============= [In Float] =============
+    [IN_FLOAT] = {
+        [ALL_CLASSES] = ACCEPT_BEFORE(FLOAT_TOKEN),
+        [DIGIT_CLASS] = GOTO(IN_FLOAT)
+    }
+};
+
 // lexeme of each token, including id and reserved word
 char lexeme[MAX_TOKEN_SIZE + 1];
 
-// max line size
-#define LINE_BUF_SIZE 256
+// source code of the last token
+SourceSpan token_span;
 
-// buffer of current line
-static char line_buf[LINE_BUF_SIZE];
-// current position in line buffer
-static int line_pos = 0;
-// current line buffer size
-static int buf_size = 0;
+// source code in memory
+static const char *src_data = NULL;
+// size of source code
+static long src_size = 0;
+// offset of the next character in source code
+static long src_pos = 0;
 // end of file flag
 static int EOF_flag = FALSE;
+// tokens lexed beforehand, read instead of the source code if not NULL
+static const TokenArray *token_source = NULL;
+// index of the next token in token_source
+static long token_index = 0;
 
-// get the next character in the line
-static char get_next_char(void) {
-    if (line_pos < buf_size) {
-        return line_buf[line_pos++];
+// lines of the source code being scanned, filled in while scanning
+LineTable line_table = { NULL, 0, 0 };
+
+// record that a line starts at offset, unless it's already known
+static void add_line_start(long offset) {
+    LineTable *lines = &line_table;
+    if (lines->num > 0 && lines->starts[lines->num - 1] >= offset) {
+        return;
     }
-    else {
-        // go to the next line
-        line_idx += 1;
-        // try to read the next line
-        if (fgets(line_buf, LINE_BUF_SIZE, src_file)) {
-            buf_size = strlen(line_buf);
-            line_pos = 0;
-            return line_buf[line_pos++];
-        }
-        else {
-            // end of file
-            EOF_flag = TRUE;
-            return EOF;
-        }
+    if (lines->num == lines->capacity) {
+        lines->capacity = lines->capacity ? lines->capacity * 2 : 1024;
+        lines->starts = (long *)realloc(lines->starts, lines->capacity * sizeof(long));
     }
+    lines->starts[lines->num] = offset;
+    lines->num += 1;
+}
+
+// get the next character in source code
+static inline int get_next_char(void) {
+    if (src_pos >= src_size) {
+        // end of file
+        EOF_flag = TRUE;
+        return EOF;
+    }
+    int c = (unsigned char)src_data[src_pos++];
+    if (c == '\n') {
+        add_line_start(src_pos);
+    }
+    return c;
 }
 
 // cancel the result of get_next_char
 static void cancel_current_char(void) {
     if (!EOF_flag) {
-        line_pos -= 1;
+        src_pos -= 1;
     }
 }
 
+// scan source code in memory from the beginning
+// (the data must stay alive while scanning and parsing)
+void set_source(const char *data, long size) {
+    src_data = data;
+    src_size = size;
+    token_source = NULL;
+    line_table.num = 0;
+    add_line_start(0);
+    reset_scanner();
+}
+
+// restart scanning from the beginning of source code
+void reset_scanner(void) {
+    scanner_seek(0);
+}
+
+// offset of the next character to scan in source code
+long scanner_offset(void) {
+    return src_pos;
+}
+
+// continue scanning at an offset of source code
+void scanner_seek(long offset) {
+    src_pos = offset;
+    EOF_flag = FALSE;
+    if (token_source != NULL) {
+        // go to the first token starting at or after offset
+        long low = 0;
+        long high = token_source->num - 1;
+        while (low < high) {
+            long middle = low + (high - low) / 2;
+            if (token_source->tokens[middle].span.start < offset) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        token_index = low;
+    }
+}
+
+// read the tokens of source code from an array lexed beforehand instead
+// of scanning it (NULL goes back to scanning from the same offset)
+void use_token_array(const TokenArray *tokens) {
+    token_source = tokens;
+    scanner_seek(src_pos);
+}
+
+// get the next token from token_source
+static TokenType next_array_token(void) {
+    const Token *token = &token_source->tokens[token_index];
+    // stay at ENDFILE_TOKEN, the last one
+    if (token_index < token_source->num - 1) {
+        token_index += 1;
+    }
+    token_span = token->span;
+    token_lexeme(token, lexeme);
+    src_pos = token->span.start + token->span.length;
+    budget_check_token(token->span.length);
+    return token->type;
+}
+
+// line of an offset in a line table, counted from 1
+int table_line(const LineTable *lines, long offset) {
+    // the number of lines starting at or before offset
+    int low = 0;
+    int high = lines->num;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (lines->starts[mid] <= offset) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// line of an offset in the scanned source code, counted from 1
+int offset_line(long offset) {
+    return table_line(&line_table, offset);
+}
+
+// column of an offset in the scanned source code, counted from 1
+int offset_column(long offset) {
+    return offset - line_table.starts[offset_line(offset) - 1] + 1;
+}
+
 // reserved word
 typedef struct {
     char *name;
@@ -90,22 +326,75 @@ static TokenType reserved_look_up(char *str) {
     return ID_TOKEN;
 }
 
-// get the next token in source file
+// get the next token in source code
 TokenType get_next_token(void) {
+    if (token_source != NULL) {
+        return next_array_token();
+    }
     // index in lexeme
     int lexeme_idx = 0;
+    // size of the token, which may be longer than lexeme
+    long token_size = 0;
     // type of current token
-    TokenType current_token;
+    TokenType current_token = ERROR_TOKEN;
+    // current DFA state
+    StateType current_dfa_state = START;
+    // DFA: one table lookup per character
+    while (current_dfa_state != DONE) {
+        int current_char = get_next_char();
+        int current_class = (current_char == EOF) ? EOF_CLASS : char_class[current_char];
+        const Transition *transition = &transitions[current_dfa_state][current_class];
+        if (transition->flags & SAVE_CHAR) {
+            if (token_size == 0) {
+                token_span.start = src_pos - 1;
+            }
+            token_size += 1;
+            if (lexeme_idx < MAX_TOKEN_SIZE) {
+                lexeme[lexeme_idx] = current_char;
+                lexeme_idx += 1;
+            }
+        }
+        else if (transition->flags & CANCEL_CHAR) {
+            cancel_current_char();
+        }
+        current_dfa_state = transition->next_state;
+        current_token = transition->token;
+    }
+    lexeme[lexeme_idx] = '\0';
+    if (token_size == 0) {
+        // end of file
+        token_span.start = src_pos;
+    }
+    token_span.length = token_size;
+    budget_check_token(token_size);
+    // check if id is a reserved word
+    if (current_token == ID_TOKEN) {
+        current_token = reserved_look_up(lexeme);
+    }
+    return current_token;
+}
+
+// get the next token in source code with the switch-based DFA the tables
+// replaced, kept so bench_lex can compare the two (it finds the same tokens;
+// the only change is that a 0xFF byte is read as an unsigned character and
+// gives an error token, where it used to be taken for end of file)
+TokenType get_next_token_switch(void) {
+    // index in lexeme
+    int lexeme_idx = 0;
+    // size of the token, which may be longer than lexeme
+    long token_size = 0;
+    // type of current token
+    TokenType current_token = ERROR_TOKEN;
     // current DFA state
     StateType current_dfa_state = START;
     // save current char to lexeme or not
     int save_current_char;
     // DFA
     while (current_dfa_state != DONE) {
-        char current_char = get_next_char();
+        int current_char = get_next_char();
         save_current_char = TRUE;
         // go to the next state
-        switch(current_dfa_state) {
+        switch (current_dfa_state) {
             // ============= [Start] =============
             case START:
                 if (current_char == ' ' || current_char == '\t' || current_char == '\n') {
@@ -118,10 +407,10 @@ TokenType get_next_token(void) {
                 else if (current_char == ':') {
                     current_dfa_state = IN_ASSIGN;
                 }
-                else if (isalpha(current_char)) {
+                else if (current_char != EOF && isalpha(current_char)) {
                     current_dfa_state = IN_ID;
                 }
-                else if (isdigit(current_char)) {
+                else if (current_char != EOF && isdigit(current_char)) {
                     current_dfa_state = IN_INTEGER;
                 }
                 else {
@@ -192,7 +481,7 @@ TokenType get_next_token(void) {
                 break;
             // ============= [In ID] =============
             case IN_ID:
-                if (!isalnum(current_char)) {
+                if (current_char == EOF || !isalnum(current_char)) {
                     // finish scanning id
                     current_token = ID_TOKEN;
                     cancel_current_char();
@@ -205,7 +494,7 @@ TokenType get_next_token(void) {
                 if (current_char == '.') {
                     current_dfa_state = IN_FLOAT;
                 }
-                else if (!isdigit(current_char)) {
+                else if (current_char == EOF || !isdigit(current_char)) {
                     // finish scanning number
                     current_token = INTEGER_TOKEN;
                     cancel_current_char();
@@ -215,7 +504,7 @@ TokenType get_next_token(void) {
                 break;
             // ============= [In Float] =============
             case IN_FLOAT:
-                if (!isdigit(current_char)) {
+                if (current_char == EOF || !isdigit(current_char)) {
                     // finish scanning number
                     current_token = FLOAT_TOKEN;
                     cancel_current_char();
@@ -223,9 +512,6 @@ TokenType get_next_token(void) {
                     current_dfa_state = DONE;
                 }
                 break;
-            // ============= [Done] =============
-            case DONE:
-                break;
             // ============= [Error] =============
             default:
                 // should never happen
@@ -234,18 +520,255 @@ TokenType get_next_token(void) {
                 break;
         }
         // save current char?
-        if (save_current_char && lexeme_idx <= MAX_TOKEN_SIZE) {
-            lexeme[lexeme_idx] = current_char;
-            lexeme_idx += 1;
-        }
-        // done?
-        if (current_dfa_state == DONE) {
-            lexeme[lexeme_idx] = '\0';
-            // check if id is a reserved word
-            if (current_token == ID_TOKEN) {
-                current_token = reserved_look_up(lexeme);
-            }  
+        if (save_current_char) {
+            if (token_size == 0) {
+                token_span.start = src_pos - 1;
+            }
+            token_size += 1;
+            if (lexeme_idx < MAX_TOKEN_SIZE) {
+                lexeme[lexeme_idx] = current_char;
+                lexeme_idx += 1;
+            }
         }
     }
+    lexeme[lexeme_idx] = '\0';
+    if (token_size == 0) {
+        // end of file
+        token_span.start = src_pos;
+    }
+    token_span.length = token_size;
+    budget_check_token(token_size);
+    // check if id is a reserved word
+    if (current_token == ID_TOKEN) {
+        current_token = reserved_look_up(lexeme);
+    }
     return current_token;
 }
+
+// a chunk of source code lexed by one thread
+typedef struct {
+    // offsets of the chunk, from after a space to after the next one
+    long start;
+    long end;
+    // tokens found starting outside a comment
+    TokenArray tokens;
+    // TRUE if the chunk ends inside a comment when it starts outside one
+    int ends_in_comment;
+    // offset of the first "}", or -1
+    long first_close;
+    // offsets where lines start in the chunk
+    LineTable lines;
+    pthread_t thread;
+    // TRUE if it's lexed by its own thread
+    int started;
+} LexChunk;
+
+// append a token to an array
+static inline void add_token(TokenArray *tokens, TokenType type, long start, long size) {
+    if (tokens->num == tokens->capacity) {
+        tokens->capacity = tokens->capacity ? tokens->capacity * 2 : 4096;
+        tokens->tokens = (Token *)realloc(tokens->tokens, tokens->capacity * sizeof(Token));
+    }
+    Token *token = &tokens->tokens[tokens->num];
+    token->type = type;
+    token->span.start = start;
+    token->span.length = size;
+    tokens->num += 1;
+}
+
+// lex a chunk starting outside a comment, the same DFA as get_next_token
+// (the chunk ends after a space, so no token goes on into the next one)
+static void* lex_chunk(void *arg) {
+    LexChunk *chunk = (LexChunk *)arg;
+    // locals, so stores to the tokens don't make the compiler reload them
+    const char *data = src_data;
+    long end = chunk->end;
+    TokenArray tokens = chunk->tokens;
+    char text[MAX_TOKEN_SIZE + 1];
+    int text_size = 0;
+    long token_start = 0;
+    long token_size = 0;
+    StateType state = START;
+    long pos = chunk->start;
+    while (pos < end) {
+        // one token, or the rest of the chunk
+        const Transition *transition;
+        text_size = 0;
+        token_size = 0;
+        do {
+            int c = (unsigned char)data[pos++];
+            transition = &transitions[state][char_class[c]];
+            if (transition->flags & SAVE_CHAR) {
+                if (token_size == 0) {
+                    token_start = pos - 1;
+                }
+                token_size += 1;
+                if (text_size < MAX_TOKEN_SIZE) {
+                    text[text_size] = c;
+                    text_size += 1;
+                }
+            }
+            else if (transition->flags & CANCEL_CHAR) {
+                pos -= 1;
+            }
+            state = transition->next_state;
+        } while (state != DONE && pos < end);
+        if (state == DONE) {
+            TokenType token = transition->token;
+            if (token == ID_TOKEN) {
+                text[text_size] = '\0';
+                token = reserved_look_up(text);
+            }
+            add_token(&tokens, token, token_start, token_size);
+            state = START;
+        }
+    }
+    if (end == src_size && state != START && state != IN_COMMENT) {
+        // end of file ends the last token
+        TokenType token = transitions[state][EOF_CLASS].token;
+        if (token == ID_TOKEN) {
+            text[text_size] = '\0';
+            token = reserved_look_up(text);
+        }
+        add_token(&tokens, token, token_start, token_size);
+        state = START;
+    }
+    chunk->tokens = tokens;
+    chunk->ends_in_comment = state == IN_COMMENT;
+    // a "}" always leaves the DFA in START, so starting inside a comment
+    // gives the tokens after the first "}", and a scan for it is enough
+    const char *close = memchr(src_data + chunk->start, '}', chunk->end - chunk->start);
+    chunk->first_close = close != NULL ? close - src_data : -1;
+    // lines
+    for (const char *p = src_data + chunk->start; p < src_data + chunk->end;) {
+        const char *newline = memchr(p, '\n', src_data + chunk->end - p);
+        if (newline == NULL) {
+            break;
+        }
+        LineTable *lines = &chunk->lines;
+        if (lines->num == lines->capacity) {
+            lines->capacity = lines->capacity ? lines->capacity * 2 : 1024;
+            lines->starts = (long *)realloc(lines->starts, lines->capacity * sizeof(long));
+        }
+        lines->starts[lines->num] = newline + 1 - src_data;
+        lines->num += 1;
+        p = newline + 1;
+    }
+    return NULL;
+}
+
+// lex the whole source code with threads into an array ending with
+// ENDFILE_TOKEN, the same tokens as calling get_next_token until the end
+// (budget checks are left to the caller), and fill in line_table
+void lex_parallel(int thread_num, TokenArray *tokens) {
+    // chunks of at least 64KB, split after a space
+    long chunk_num = src_size / 65536 + 1;
+    if (chunk_num > thread_num) {
+        chunk_num = thread_num;
+    }
+    LexChunk *chunks = (LexChunk *)calloc(chunk_num, sizeof(LexChunk));
+    long start = 0;
+    int num = 0;
+    for (int i = 0; i < chunk_num; i++) {
+        long end = i == chunk_num - 1 ? src_size : src_size / chunk_num * (i + 1);
+        if (end < start) {
+            end = start;
+        }
+        while (end < src_size && char_class[(unsigned char)src_data[end]] != SPACE_CLASS) {
+            end += 1;
+        }
+        if (end < src_size) {
+            end += 1;
+        }
+        if (end > start || i == 0) {
+            chunks[num].start = start;
+            chunks[num].end = end;
+            num += 1;
+        }
+        start = end;
+    }
+    for (int i = 1; i < num; i++) {
+        chunks[i].started = pthread_create(&chunks[i].thread, NULL, lex_chunk, &chunks[i]) == 0;
+        if (!chunks[i].started) {
+            // lex it here when there are no more threads
+            lex_chunk(&chunks[i]);
+        }
+    }
+    lex_chunk(&chunks[0]);
+    for (int i = 1; i < num; i++) {
+        if (chunks[i].started) {
+            pthread_join(chunks[i].thread, NULL);
+        }
+    }
+
+    // pick the result of each chunk from the state the one before ends in
+    long *first = (long *)malloc(num * sizeof(long));
+    long total = 1;
+    int in_comment = FALSE;
+    for (int i = 0; i < num; i++) {
+        LexChunk *chunk = &chunks[i];
+        first[i] = 0;
+        if (in_comment) {
+            if (chunk->first_close < 0) {
+                first[i] = chunk->tokens.num;
+                continue;
+            }
+            // skip the tokens starting before the end of the comment
+            long low = 0;
+            long high = chunk->tokens.num;
+            while (low < high) {
+                long mid = (low + high) / 2;
+                if (chunk->tokens.tokens[mid].span.start <= chunk->first_close) {
+                    low = mid + 1;
+                }
+                else {
+                    high = mid;
+                }
+            }
+            first[i] = low;
+        }
+        total += chunk->tokens.num - first[i];
+        in_comment = chunk->ends_in_comment;
+    }
+
+    // join the tokens and the lines
+    tokens->num = 0;
+    if (tokens->capacity < total) {
+        tokens->capacity = total;
+        tokens->tokens = (Token *)realloc(tokens->tokens, total * sizeof(Token));
+    }
+    line_table.num = 0;
+    add_line_start(0);
+    for (int i = 0; i < num; i++) {
+        LexChunk *chunk = &chunks[i];
+        long chunk_tokens = chunk->tokens.num - first[i];
+        if (chunk_tokens > 0) {
+            memcpy(tokens->tokens + tokens->num, chunk->tokens.tokens + first[i],
+                   chunk_tokens * sizeof(Token));
+        }
+        tokens->num += chunk_tokens;
+        if (line_table.num + chunk->lines.num > line_table.capacity) {
+            while (line_table.num + chunk->lines.num > line_table.capacity) {
+                line_table.capacity *= 2;
+            }
+            line_table.starts = (long *)realloc(line_table.starts, line_table.capacity * sizeof(long));
+        }
+        if (chunk->lines.num > 0) {
+            memcpy(line_table.starts + line_table.num, chunk->lines.starts,
+                   chunk->lines.num * sizeof(long));
+        }
+        line_table.num += chunk->lines.num;
+        free(chunk->tokens.tokens);
+        free(chunk->lines.starts);
+    }
+    add_token(tokens, ENDFILE_TOKEN, src_size, 0);
+    free(first);
+    free(chunks);
+}
+
+// copy the lexeme of a token of the source code being scanned
+void token_lexeme(const Token *token, char *text) {
+    long size = token->span.length < MAX_TOKEN_SIZE ? token->span.length : MAX_TOKEN_SIZE;
+    memcpy(text, src_data + token->span.start, size);
+    text[size] = '\0';
+}
@@ -0,0 +1,81 @@
+#include "symtab.h"
+#include <stdlib.h>
+#include <string.h>
+
+// initial number of slots
+#define INIT_CAPACITY 64
+
+// FNV-1a hash of a string
+static unsigned int hash_name(const char *name) {
+    unsigned int h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p != '\0'; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+// initialize an empty table
+void st_init(SymTab *table) {
+    table->slots = (Symbol *)calloc(INIT_CAPACITY, sizeof(Symbol));
+    table->capacity = INIT_CAPACITY;
+    table->size = 0;
+}
+
+// free memory of the table, but not the names
+void st_free(SymTab *table) {
+    free(table->slots);
+    table->slots = NULL;
+    table->capacity = 0;
+    table->size = 0;
+}
+
+// find the slot of a name, which is empty if the name is not in the table
+static Symbol* find_slot(Symbol *slots, int capacity, const char *name, unsigned int h) {
+    int mask = capacity - 1;
+    int i = h & mask;
+    while (slots[i].name != NULL) {
+        if (slots[i].hash == h && !strcmp(slots[i].name, name)) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+// double the capacity and rehash every symbol
+static void grow(SymTab *table) {
+    int capacity = table->capacity * 2;
+    Symbol *slots = (Symbol *)calloc(capacity, sizeof(Symbol));
+    for (int i = 0; i < table->capacity; i++) {
+        Symbol *s = &table->slots[i];
+        if (s->name != NULL) {
+            *find_slot(slots, capacity, s->name, s->hash) = *s;
+        }
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+}
+
+// find a symbol, or return NULL if it's not in the table
+Symbol* st_lookup(SymTab *table, const char *name) {
+    Symbol *s = find_slot(table->slots, table->capacity, name, hash_name(name));
+    return (s->name != NULL) ? s : NULL;
+}
+
+// find a symbol, or add it with value 0 if it's not in the table
+Symbol* st_insert(SymTab *table, const char *name) {
+    // keep the load factor below 1/2
+    if ((table->size + 1) * 2 > table->capacity) {
+        grow(table);
+    }
+    unsigned int h = hash_name(name);
+    Symbol *s = find_slot(table->slots, table->capacity, name, h);
+    if (s->name == NULL) {
+        s->name = name;
+        s->hash = h;
+        s->value = 0;
+        table->size += 1;
+    }
+    return s;
+}
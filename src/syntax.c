@@ -0,0 +1,50 @@
+#include "syntax.h"
+#include "scanner.h"
+#include "tree.h"
+#include "util.h"
+
+// current token
+TokenType current_token;
+// offset right after the last matched token
+long last_token_end;
+
+// take the current token as matched and scan the next one
+void advance_token(void) {
+    last_token_end = token_span.start + token_span.length;
+    current_token = get_next_token();
+}
+
+// report a syntax error at the current token
+void syntax_error(const char *message) {
+    SYNTAX_ERROR = TRUE;
+    report_error("Syntax", token_span.start, "%s", message);
+}
+
+// report the current token as unexpected
+void unexpected_token(void) {
+    char text[MAX_TOKEN_TEXT];
+    format_token(text, sizeof(text), current_token, lexeme);
+    SYNTAX_ERROR = TRUE;
+    report_error("Syntax", token_span.start, "Unexpected Token -> %s", text);
+}
+
+// end the span of a node at the last matched token
+TreeNode* finish_node(TreeNode *t) {
+    if (t != NULL && last_token_end > t->span.start) {
+        t->span.length = last_token_end - t->span.start;
+    }
+    return t;
+}
+
+// create an operator node for the current token with its left operand
+TreeNode* new_op_node(TreeNode *left) {
+    TreeNode *t = new_expr_node(OP_EXPR);
+    if (t != NULL) {
+        t->child[0] = left;
+        t->attr.op = current_token;
+        if (left != NULL) {
+            t->span.start = left->span.start;
+        }
+    }
+    return t;
+}
\ No newline at end of file
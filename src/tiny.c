@@ -0,0 +1,157 @@
+#include "tiny.h"
+#include "parser.h"
+#include "scanner.h"
+#include "tree.h"
+#include "analyze.h"
+#include "budget.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct TinyResult {
+    // the syntax tree, NULL after a syntax error
+    TreeNode *ast;
+    TinyDiagnostic *diagnostics;
+    int diagnostic_num;
+    int diagnostic_capacity;
+    // lines of the source code
+    LineTable lines;
+};
+
+// the result being filled in by tiny_parse_buffer
+static TinyResult *current_result = NULL;
+
+// collect an error as a diagnostic instead of printing it
+static void collect_error(const char *kind, long offset, const char *message) {
+    TinyResult *result = current_result;
+    if (result->diagnostic_num == result->diagnostic_capacity) {
+        result->diagnostic_capacity = result->diagnostic_capacity ? result->diagnostic_capacity * 2 : 8;
+        result->diagnostics = (TinyDiagnostic *)realloc(result->diagnostics,
+                              result->diagnostic_capacity * sizeof(TinyDiagnostic));
+    }
+    TinyDiagnostic *d = &result->diagnostics[result->diagnostic_num];
+    d->kind = kind;
+    d->offset = offset;
+    d->line = offset_line(offset);
+    d->column = offset_column(offset);
+    d->message = strdup(message);
+    result->diagnostic_num += 1;
+}
+
+// a limit from the options: 0 keeps the default, -1 means no limit
+static long option_limit(long value, long default_value) {
+    if (value == 0) {
+        return default_value;
+    }
+    return value < 0 ? 0 : value;
+}
+
+// parse source code of len bytes, options may be NULL
+TinyResult* tiny_parse_buffer(const char *data, size_t len, const TinyOptions *options) {
+    TinyOptions default_options;
+    if (options == NULL) {
+        memset(&default_options, 0, sizeof(default_options));
+        options = &default_options;
+    }
+    TinyResult *result = (TinyResult *)calloc(1, sizeof(TinyResult));
+    if (result == NULL) {
+        return NULL;
+    }
+
+    // set up the parser, keeping what the caller may have set
+    Budget saved_budget = budget;
+    int saved_lazy_parse = LAZY_PARSE;
+    int saved_table_parse = TABLE_PARSE;
+    int saved_lex_threads = LEX_THREADS;
+    void (*saved_handler)(const char *, long, const char *) = error_handler;
+    Budget default_budget = { 1000, 0, 0, 0, 0 };
+    budget.max_depth = option_limit(options->max_depth, default_budget.max_depth);
+    budget.max_nodes = option_limit(options->max_nodes, default_budget.max_nodes);
+    budget.max_bytes = option_limit(options->max_bytes, default_budget.max_bytes);
+    budget.max_token_size = option_limit(options->max_token_size, default_budget.max_token_size);
+    budget.max_millis = option_limit(options->max_millis, default_budget.max_millis);
+    LAZY_PARSE = FALSE;
+    TABLE_PARSE = options->table_parse;
+    LEX_THREADS = 1;
+    error_handler = collect_error;
+    current_result = result;
+
+    // parse and check
+    SYNTAX_ERROR = FALSE;
+    set_source(data, len);
+    TreeNode *ast = parse();
+    if (SYNTAX_ERROR) {
+        free_tree(ast);
+        ast = NULL;
+    }
+    else if (options->analyze) {
+        analyze(ast);
+    }
+    result->ast = ast;
+    // keep the lines, the scanner starts a new table for the next source
+    result->lines = line_table;
+    line_table = (LineTable){ NULL, 0, 0 };
+
+    budget = saved_budget;
+    LAZY_PARSE = saved_lazy_parse;
+    TABLE_PARSE = saved_table_parse;
+    LEX_THREADS = saved_lex_threads;
+    error_handler = saved_handler;
+    current_result = NULL;
+    return result;
+}
+
+// the syntax tree, or NULL if there's a syntax or resource error
+const TinyNode* tiny_ast(const TinyResult *result) {
+    return result->ast;
+}
+
+// the diagnostics in the order they were found, and how many there are
+const TinyDiagnostic* tiny_diagnostics(const TinyResult *result, int *num) {
+    *num = result->diagnostic_num;
+    return result->diagnostics;
+}
+
+// line and column of an offset in the source code, counted from 1
+void tiny_position(const TinyResult *result, long offset, int *line, int *column) {
+    *line = table_line(&result->lines, offset);
+    *column = offset - result->lines.starts[*line - 1] + 1;
+}
+
+// free memory of the result, including its tree
+void tiny_destroy(TinyResult *result) {
+    if (result == NULL) {
+        return;
+    }
+    free_tree(result->ast);
+    for (int i = 0; i < result->diagnostic_num; i++) {
+        free((char *)result->diagnostics[i].message);
+    }
+    free(result->diagnostics);
+    free(result->lines.starts);
+    free(result);
+}
+
+// a child of a node, from index 0 up to 2, or NULL
+const TinyNode* tiny_node_child(const TinyNode *node, int index) {
+    if (index < 0 || index >= MAX_CHILDREN) {
+        return NULL;
+    }
+    return node->child[index];
+}
+
+// the next node in a list of statements or procedures, or NULL
+const TinyNode* tiny_node_sibling(const TinyNode *node) {
+    return node->sibling;
+}
+
+// write the label of a node, e.g. "Assign to: x", as bin/tiny prints it
+void tiny_node_label(const TinyNode *node, char *buffer, size_t size) {
+    format_node(buffer, size, node);
+}
+
+// byte offset and length of the source code of a node
+void tiny_node_span(const TinyNode *node, long *start, long *length) {
+    *start = node->span.start;
+    *length = node->span.length;
+}
\ No newline at end of file
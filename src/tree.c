@@ -1,60 +1,96 @@
 #include "tree.h"
+#include "budget.h"
+#include "scanner.h"
 #include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
 
-// create a procedure definition node
-TreeNode* new_proc_node() {
-    TreeNode *t = (TreeNode *)malloc(sizeof(TreeNode));
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// create a node with no children, or return NULL if it's over budget
+static TreeNode* new_node(NodeType node_type) {
+    TreeNode *t = (TreeNode *)budget_new_node(sizeof(TreeNode));
+    if (t == NULL) {
+        return NULL;
+    }
     for (int i = 0; i < MAX_CHILDREN; i++) {
         t->child[i] = NULL;
     }
     t->sibling = NULL;
-    t->node_type = PROC_NODE;
-    t->line_idx = line_idx;
+    t->node_type = node_type;
+    // the parser sets the length once the node is complete
+    t->span.start = token_span.start;
+    t->span.length = 0;
+    t->hash = 0;
+    t->value_type = NO_TYPE;
+    t->attr.name = NULL;
     return t;
 }
 
+// create a procedure definition node
+TreeNode* new_proc_node() {
+    return new_node(PROC_NODE);
+}
+
 // create a statement node
 TreeNode* new_stmt_node(StmtType stmt_type) {
-    TreeNode *t = (TreeNode *)malloc(sizeof(TreeNode));
-    for (int i = 0; i < MAX_CHILDREN; i++) {
-        t->child[i] = NULL;
+    TreeNode *t = new_node(STMT_NODE);
+    if (t != NULL) {
+        t->type.stmt_type = stmt_type;
     }
-    t->sibling = NULL;
-    t->node_type = STMT_NODE;
-    t->type.stmt_type = stmt_type;
-    t->line_idx = line_idx;
     return t;
 }
 
 // create an expression node
 TreeNode* new_expr_node(ExprType expr_type) {
-    TreeNode *t = (TreeNode *)malloc(sizeof(TreeNode));
-    for (int i = 0; i < MAX_CHILDREN; i++) {
-        t->child[i] = NULL;
+    TreeNode *t = new_node(EXPR_NODE);
+    if (t != NULL) {
+        t->type.expr_type = expr_type;
     }
-    t->sibling = NULL;
-    t->node_type = EXPR_NODE;
-    t->type.expr_type = expr_type;
-    t->line_idx = line_idx;
     return t;
 }
 
+// check if the node owns a name
+static int has_name(TreeNode *t) {
+    if (t->node_type == STMT_NODE) {
+        return t->type.stmt_type == READ_STMT || t->type.stmt_type == ASSIGN_STMT
+               || t->type.stmt_type == PROC_CALL_STMT;
+    }
+    else if (t->node_type == EXPR_NODE) {
+        return t->type.expr_type == ID_EXPR;
+    }
+    return FALSE;
+}
+
 // free memory of the tree
+// (loops over siblings, so only nesting uses the stack)
 void free_tree(TreeNode *t) {
-    if (t != NULL) {
-        // free sibling
-        free_tree(t->sibling);
+    while (t != NULL) {
+        TreeNode *next = t->sibling;
         // free subtrees
         for (int i = 0; i < MAX_CHILDREN; i++) {
             free_tree(t->child[i]);
         }
         // free this node
+        if (has_name(t)) {
+            free(t->attr.name);
+        }
+        else if (t->node_type == PROC_NODE) {
+            free(t->attr.lazy);
+        }
         free(t);
+        t = next;
     }
 }
 
-// print a token
-void print_token(TokenType token_type, const char *lexeme) {
+// write the text of a token, e.g. "ID: x", to a buffer
+void format_token(char *buffer, size_t size, TokenType token_type, const char *lexeme) {
     switch (token_type) {
         case READ_TOKEN:
         case WRITE_TOKEN:
@@ -69,61 +105,68 @@ void print_token(TokenType token_type, const char *lexeme) {
         case PROC_TOKEN:
         case BEGIN_TOKEN:
         case CALL_TOKEN:
-            fprintf(result_file, "Reserved Word: %s\n", lexeme);
+            snprintf(buffer, size, "Reserved Word: %s", lexeme);
             break;
         case ASSIGN_TOKEN:
-            fprintf(result_file, ":=\n");
+            snprintf(buffer, size, ":=");
             break;
         case EQ_TOKEN:
-            fprintf(result_file, "=\n");
+            snprintf(buffer, size, "=");
             break;
         case LT_TOKEN:
-            fprintf(result_file, "<\n");
+            snprintf(buffer, size, "<");
             break;
         case ADD_TOKEN:
-            fprintf(result_file, "+\n");
+            snprintf(buffer, size, "+");
             break;
         case SUB_TOKEN:
-            fprintf(result_file, "-\n");
+            snprintf(buffer, size, "-");
             break;
         case MUL_TOKEN:
-            fprintf(result_file, "*\n");
+            snprintf(buffer, size, "*");
             break;
         case DIV_TOKEN:
-            fprintf(result_file, "/\n");
+            snprintf(buffer, size, "/");
             break;
         case LPAREN_TOKEN:
-            fprintf(result_file, "(\n");
+            snprintf(buffer, size, "(");
             break;
         case RPAREN_TOKEN:
-            fprintf(result_file, ")\n");
+            snprintf(buffer, size, ")");
             break;
         case SEMI_TOKEN:
-            fprintf(result_file, ";\n");
+            snprintf(buffer, size, ";");
             break;
         case ID_TOKEN:
-            fprintf(result_file, "ID: %s\n", lexeme);
+            snprintf(buffer, size, "ID: %s", lexeme);
             break;
         case INTEGER_TOKEN:
-            fprintf(result_file, "Integer: %s\n", lexeme);
+            snprintf(buffer, size, "Integer: %s", lexeme);
             break;
         case FLOAT_TOKEN:
-            fprintf(result_file, "Float: %s\n", lexeme);
+            snprintf(buffer, size, "Float: %s", lexeme);
             break;
         case ERROR_TOKEN:
-            fprintf(result_file, "Error: %s\n", lexeme);
+            snprintf(buffer, size, "Error: %s", lexeme);
             break;
         default:
-            fprintf(result_file, "Unknown Token: %s\n", lexeme);
+            snprintf(buffer, size, "Unknown Token: %s", lexeme);
             break;
     }
 }
 
+// print a token
+void print_token(TokenType token_type, const char *lexeme) {
+    char text[MAX_TOKEN_TEXT];
+    format_token(text, sizeof(text), token_type, lexeme);
+    fprintf(result_file, "%s\n", text);
+}
+
 // indent spaces
 #define INDENT_SPACES 4
 
-// the number of indent spaces
-static int indent_space_num = -INDENT_SPACES;
+// the number of indent spaces (per thread, like result_file)
+static __thread int indent_space_num = -INDENT_SPACES;
 
 // increase indentation
 #define INC_INDENT indent_space_num += INDENT_SPACES
@@ -137,69 +180,108 @@ static void print_spaces() {
     }
 }
 
-// print a tree
-void print_tree(TreeNode *t) {
-    INC_INDENT;
-    while (t != NULL) {
-        print_spaces();
-        if (t->node_type == PROC_NODE) {
-            fprintf(result_file, "Function Definition\n");
-        }
-        else if (t->node_type == STMT_NODE) {
-            // print statement node
-            switch (t->type.stmt_type) {
-                case READ_STMT:
-                    fprintf(result_file, "Read: %s\n", t->attr.name);
-                    break;
-                case WRITE_STMT:
-                    fprintf(result_file, "Write\n");
-                    break;
-                case IF_STMT:
-                    fprintf(result_file, "If\n");
-                    break;
-                case REPEAT_STMT:
-                    fprintf(result_file, "Repeat\n");
-                    break;
-                case BREAK_STMT:
-                    fprintf(result_file, "Break\n");
-                    break;
-                case CONTINUE_STMT:
-                    fprintf(result_file, "Continue\n");
-                    break;
-                case ASSIGN_STMT:
-                    fprintf(result_file, "Assign to: %s\n", t->attr.name);
-                    break;
-                case PROC_CALL_STMT:
-                    fprintf(result_file, "Call Procedure: %s\n", t->attr.name);
-                    break;
-                default:
-                    fprintf(result_file, "Unknown Statement Type\n");
-                    break;
-            }
+// print source spans of nodes or not
+int PRINT_SPANS = FALSE;
+
+// print the source span of a node as [line:column-line:column]
+static void print_span(TreeNode *t) {
+    long start = t->span.start;
+    long end = start + t->span.length;
+    fprintf(result_file, "[%d:%d-%d:%d] ", offset_line(start), offset_column(start),
+            offset_line(end), offset_column(end));
+}
+
+// write the label of a node, e.g. "Assign to: x", to a buffer
+void format_node(char *buffer, size_t size, const TreeNode *t) {
+    if (t->node_type == PROC_NODE) {
+        snprintf(buffer, size, "Function Definition");
+    }
+    else if (t->node_type == STMT_NODE) {
+        // statement node
+        switch (t->type.stmt_type) {
+            case READ_STMT:
+                snprintf(buffer, size, "Read: %s", t->attr.name);
+                break;
+            case WRITE_STMT:
+                snprintf(buffer, size, "Write");
+                break;
+            case IF_STMT:
+                snprintf(buffer, size, "If");
+                break;
+            case REPEAT_STMT:
+                snprintf(buffer, size, "Repeat");
+                break;
+            case BREAK_STMT:
+                snprintf(buffer, size, "Break");
+                break;
+            case CONTINUE_STMT:
+                snprintf(buffer, size, "Continue");
+                break;
+            case ASSIGN_STMT:
+                snprintf(buffer, size, "Assign to: %s", t->attr.name);
+                break;
+            case PROC_CALL_STMT:
+                snprintf(buffer, size, "Call Procedure: %s", t->attr.name);
+                break;
+            default:
+                snprintf(buffer, size, "Unknown Statement Type");
+                break;
         }
-        else if (t->node_type == EXPR_NODE) {
-            // print expression node
-            switch (t->type.expr_type) {
-                case ID_EXPR:
-                    fprintf(result_file, "ID: %s\n", t->attr.name);
-                    break;
-                case INTEGER_EXPR:
-                    fprintf(result_file, "Integer: %d\n", t->attr.integer_val);
-                    break;
-                case FLOAT_EXPR:
-                    fprintf(result_file, "Float: %f\n", t->attr.float_val);
-                    break;
-                case OP_EXPR:
-                    fprintf(result_file, "Op: ");
-                    print_token(t->attr.op, NULL);
-                    break;
-                default:
-                    fprintf(result_file, "Unknown Expression Type\n");
-                    break;
+    }
+    else if (t->node_type == EXPR_NODE) {
+        // expression node
+        switch (t->type.expr_type) {
+            case ID_EXPR:
+                snprintf(buffer, size, "ID: %s", t->attr.name);
+                break;
+            case INTEGER_EXPR:
+                snprintf(buffer, size, "Integer: %d", t->attr.integer_val);
+                break;
+            case FLOAT_EXPR:
+                snprintf(buffer, size, "Float: %f", t->attr.float_val);
+                break;
+            case OP_EXPR: {
+                char op[MAX_TOKEN_TEXT];
+                format_token(op, sizeof(op), t->attr.op, NULL);
+                snprintf(buffer, size, "Op: %s", op);
+                break;
             }
+            default:
+                snprintf(buffer, size, "Unknown Expression Type");
+                break;
         }
-        else {
-            fprintf(result_file, "Unknown Node Type");
+    }
+    else {
+        snprintf(buffer, size, "Unknown Node Type");
+    }
+}
+
+// print the label of a node on one line, e.g. "Assign to: x"
+void print_node(TreeNode *t) {
+    char text[MAX_TOKEN_TEXT];
+    format_node(text, sizeof(text), t);
+    fprintf(result_file, "%s\n", text);
+}
+
+// print the nodes of a list from t up to end
+static void print_list(TreeNode *t, TreeNode *end) {
+    INC_INDENT;
+    while (t != end) {
+        print_spaces();
+        if (PRINT_SPANS) {
+            print_span(t);
+        }
+        print_node(t);
+        if (t->node_type == PROC_NODE && t->attr.lazy != NULL) {
+            // print where the unparsed body is
+            print_tree(t->child[0]);
+            INC_INDENT;
+            print_spaces();
+            fprintf(result_file, "Body: line %d, bytes %ld-%ld\n", offset_line(t->attr.lazy->start),
+                    t->attr.lazy->start, t->attr.lazy->end);
+            DEC_INDENT;
+            t = t->sibling;
+            continue;
         }
         // print children
         for (int i = 0; i < MAX_CHILDREN; i++) {
@@ -210,3 +292,125 @@ void print_tree(TreeNode *t) {
     }
     DEC_INDENT;
 }
+
+// print a tree
+void print_tree(TreeNode *t) {
+    print_list(t, NULL);
+}
+
+// a part of the top-level list printed by one thread
+typedef struct {
+    TreeNode *first;
+    TreeNode *end;
+    // printed text, NULL if it couldn't be buffered
+    char *data;
+    size_t size;
+    pthread_t thread;
+    int started;
+} PrintChunk;
+
+// print a chunk into a buffer of its own
+static void* print_chunk(void *arg) {
+    PrintChunk *chunk = (PrintChunk *)arg;
+    FILE *saved_file = result_file;
+    result_file = open_memstream(&chunk->data, &chunk->size);
+    if (result_file != NULL) {
+        print_list(chunk->first, chunk->end);
+        fclose(result_file);
+    }
+    else {
+        chunk->data = NULL;
+    }
+    result_file = saved_file;
+    return NULL;
+}
+
+// write all of a list of buffers to a file descriptor, at most IOV_MAX
+// at a time (return FALSE and print the reason if a write fails)
+static int write_all(int fd, struct iovec *iov, int num) {
+    while (num > 0) {
+        ssize_t n = writev(fd, iov, num < IOV_MAX ? num : IOV_MAX);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Can't write the AST: %s\n", strerror(errno));
+            return FALSE;
+        }
+        // skip what was written
+        while (num > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov += 1;
+            num -= 1;
+        }
+        if (num > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return TRUE;
+}
+
+// print a tree with threads, each formatting a part of the top-level list
+// (the output is the same as print_tree)
+void print_tree_parallel(TreeNode *t, int thread_num) {
+    long node_num = 0;
+    for (TreeNode *p = t; p != NULL; p = p->sibling) {
+        node_num += 1;
+    }
+    if (thread_num <= 1 || node_num < thread_num) {
+        print_tree(t);
+        return;
+    }
+    // split the top-level list evenly
+    PrintChunk *chunks = (PrintChunk *)calloc(thread_num, sizeof(PrintChunk));
+    TreeNode *p = t;
+    long index = 0;
+    for (int i = 0; i < thread_num; i++) {
+        chunks[i].first = p;
+        long end_index = node_num * (i + 1) / thread_num;
+        for (; index < end_index; index++) {
+            p = p->sibling;
+        }
+        chunks[i].end = p;
+    }
+    for (int i = 0; i < thread_num; i++) {
+        chunks[i].started = !pthread_create(&chunks[i].thread, NULL, print_chunk, &chunks[i]);
+        if (!chunks[i].started) {
+            print_chunk(&chunks[i]);
+        }
+    }
+    for (int i = 0; i < thread_num; i++) {
+        if (chunks[i].started) {
+            pthread_join(chunks[i].thread, NULL);
+        }
+    }
+    // write the buffers in order, printing any that couldn't be buffered
+    fflush(result_file);
+    struct iovec *iov = (struct iovec *)malloc(thread_num * sizeof(struct iovec));
+    int iov_num = 0;
+    int ok = TRUE;
+    for (int i = 0; i < thread_num && ok; i++) {
+        if (chunks[i].data != NULL) {
+            iov[iov_num].iov_base = chunks[i].data;
+            iov[iov_num].iov_len = chunks[i].size;
+            iov_num += 1;
+        }
+        else {
+            ok = write_all(fileno(result_file), iov, iov_num);
+            iov_num = 0;
+            if (ok) {
+                print_list(chunks[i].first, chunks[i].end);
+                fflush(result_file);
+            }
+        }
+    }
+    if (ok) {
+        write_all(fileno(result_file), iov, iov_num);
+    }
+    for (int i = 0; i < thread_num; i++) {
+        free(chunks[i].data);
+    }
+    free(iov);
+    free(chunks);
+}
\ No newline at end of file
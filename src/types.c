@@ -0,0 +1,449 @@
+#include "types.h"
+#include "parser.h"
+#include "scanner.h"
+#include "symtab.h"
+#include "tree.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The types at a point of the program are an array with the types of the
+// variables, by index, and one more entry that is INT_TYPE if the point can
+// be reached. Where paths meet, the arrays are joined with OR, and loops and
+// procedures are walked again until the types stop growing, which happens
+// after a few passes because each entry can only grow twice.
+
+// what is known about a procedure
+typedef struct {
+    TreeNode *node;
+    // types at the start of the body, joined over the calls
+    ValueType *entry;
+    // types at the end of the body
+    ValueType *exit;
+    // variables the body, or a procedure it calls, may assign
+    char *assigned;
+} ProcTypes;
+
+// types where a repeat body is left by break and by continue
+typedef struct {
+    ValueType *breaks;
+    ValueType *continues;
+} LoopTypes;
+
+// variable name -> 1 + index
+static SymTab var_table;
+static const char **var_names;
+static int var_num;
+static int var_capacity;
+// types each variable has anywhere in the program
+static ValueType *var_types;
+
+// procedure name -> 1 + index in procs
+static SymTab proc_table;
+static ProcTypes *procs;
+static int proc_num;
+
+// the innermost repeat statement
+static LoopTypes *current_loop;
+// set when the types at the start or end of a procedure grow
+static int procs_changed;
+
+static void infer_stmts(TreeNode *t, ValueType *types);
+
+// check if a point with these types can be reached
+#define REACHED(types) ((types)[var_num] != NO_TYPE)
+
+// types of a point that can't be reached
+static ValueType* new_types(void) {
+    return (ValueType *)calloc(var_num + 1, sizeof(ValueType));
+}
+
+// copy types
+static ValueType* copy_types(const ValueType *types) {
+    ValueType *copy = (ValueType *)malloc((var_num + 1) * sizeof(ValueType));
+    memcpy(copy, types, (var_num + 1) * sizeof(ValueType));
+    return copy;
+}
+
+// join types into others, and return TRUE if they grew
+static int join_types(ValueType *into, const ValueType *from) {
+    int grew = FALSE;
+    for (int i = 0; i <= var_num; i++) {
+        ValueType joined = (ValueType)(into[i] | from[i]);
+        if (joined != into[i]) {
+            into[i] = joined;
+            grew = TRUE;
+        }
+    }
+    return grew;
+}
+
+// find the index of a variable, adding it if it's new
+static int add_var(const char *name) {
+    Symbol *s = st_insert(&var_table, name);
+    if (s->value == 0) {
+        if (var_num == var_capacity) {
+            var_capacity = var_capacity ? var_capacity * 2 : 64;
+            var_names = (const char **)realloc(var_names, var_capacity * sizeof(char *));
+        }
+        var_names[var_num] = name;
+        var_num += 1;
+        s->value = var_num;
+    }
+    return s->value - 1;
+}
+
+// find the variables in statements, and clear the types of their expressions
+static void collect_vars(TreeNode *t) {
+    for (; t != NULL; t = t->sibling) {
+        if (t->node_type == EXPR_NODE) {
+            t->value_type = NO_TYPE;
+            if (t->type.expr_type == ID_EXPR) {
+                add_var(t->attr.name);
+            }
+        }
+        else if (t->type.stmt_type == READ_STMT || t->type.stmt_type == ASSIGN_STMT) {
+            add_var(t->attr.name);
+        }
+        for (int i = 0; i < MAX_CHILDREN; i++) {
+            collect_vars(t->child[i]);
+        }
+    }
+}
+
+// mark the variables that statements assign, directly or through the
+// procedures they call, and return TRUE if any was not marked yet
+static int collect_assigned(TreeNode *t, char *assigned) {
+    int grew = FALSE;
+    for (; t != NULL; t = t->sibling) {
+        switch (t->type.stmt_type) {
+            case READ_STMT:
+            case ASSIGN_STMT: {
+                int var = add_var(t->attr.name);
+                grew |= !assigned[var];
+                assigned[var] = TRUE;
+                break;
+            }
+            case IF_STMT:
+                grew |= collect_assigned(t->child[1], assigned);
+                grew |= collect_assigned(t->child[2], assigned);
+                break;
+            case REPEAT_STMT:
+                grew |= collect_assigned(t->child[0], assigned);
+                break;
+            case PROC_CALL_STMT: {
+                Symbol *s = st_lookup(&proc_table, t->attr.name);
+                if (s == NULL) {
+                    break;
+                }
+                const char *called = procs[s->value - 1].assigned;
+                for (int i = 0; i < var_num; i++) {
+                    grew |= called[i] && !assigned[i];
+                    assigned[i] |= called[i];
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return grew;
+}
+
+// infer the type of an expression from the types of the variables
+static ValueType infer_expr(TreeNode *t, const ValueType *types) {
+    ValueType type;
+    switch (t->type.expr_type) {
+        case ID_EXPR: {
+            int var = add_var(t->attr.name);
+            type = types[var];
+            var_types[var] |= type;
+            break;
+        }
+        case INTEGER_EXPR:
+            type = INT_TYPE;
+            break;
+        case FLOAT_EXPR:
+            type = FLOAT_TYPE;
+            break;
+        default: {
+            ValueType left = infer_expr(t->child[0], types);
+            ValueType right = infer_expr(t->child[1], types);
+            if (left == NO_TYPE || right == NO_TYPE) {
+                type = NO_TYPE;
+            }
+            else if (t->attr.op == LT_TOKEN || t->attr.op == EQ_TOKEN) {
+                // comparisons give integer 1 or 0
+                type = INT_TYPE;
+            }
+            else {
+                // integer if both sides may be integers, float if either may be float
+                type = (ValueType)((left & right & INT_TYPE) | ((left | right) & FLOAT_TYPE));
+            }
+            break;
+        }
+    }
+    // a loop or procedure walked again can only widen the type
+    t->value_type |= type;
+    return type;
+}
+
+// infer the types after a statement, updating the types before it
+static void infer_stmt(TreeNode *t, ValueType *types) {
+    switch (t->type.stmt_type) {
+        case READ_STMT: {
+            // the input decides
+            int var = add_var(t->attr.name);
+            types[var] = MIXED_TYPE;
+            var_types[var] = MIXED_TYPE;
+            break;
+        }
+        case WRITE_STMT:
+            infer_expr(t->child[0], types);
+            break;
+        case IF_STMT: {
+            infer_expr(t->child[0], types);
+            ValueType *else_types = copy_types(types);
+            infer_stmts(t->child[1], types);
+            infer_stmts(t->child[2], else_types);
+            join_types(types, else_types);
+            free(else_types);
+            break;
+        }
+        case REPEAT_STMT: {
+            LoopTypes loop = { new_types(), new_types() };
+            LoopTypes *saved_loop = current_loop;
+            current_loop = &loop;
+            // walk the body until the types at its start include the types
+            // coming back from the condition
+            ValueType *start = copy_types(types);
+            for (;;) {
+                memcpy(types, start, (var_num + 1) * sizeof(ValueType));
+                infer_stmts(t->child[0], types);
+                // continue goes on to the condition
+                join_types(types, loop.continues);
+                if (REACHED(types)) {
+                    infer_expr(t->child[1], types);
+                }
+                if (!join_types(start, types)) {
+                    break;
+                }
+            }
+            join_types(types, loop.breaks);
+            current_loop = saved_loop;
+            free(start);
+            free(loop.breaks);
+            free(loop.continues);
+            break;
+        }
+        case BREAK_STMT:
+            join_types(current_loop->breaks, types);
+            memset(types, 0, (var_num + 1) * sizeof(ValueType));
+            break;
+        case CONTINUE_STMT:
+            join_types(current_loop->continues, types);
+            memset(types, 0, (var_num + 1) * sizeof(ValueType));
+            break;
+        case ASSIGN_STMT: {
+            ValueType type = infer_expr(t->child[0], types);
+            int var = add_var(t->attr.name);
+            types[var] = type;
+            var_types[var] |= type;
+            break;
+        }
+        case PROC_CALL_STMT: {
+            Symbol *s = st_lookup(&proc_table, t->attr.name);
+            if (s == NULL) {
+                // the program stops with a runtime error
+                memset(types, 0, (var_num + 1) * sizeof(ValueType));
+                break;
+            }
+            ProcTypes *proc = &procs[s->value - 1];
+            procs_changed |= join_types(proc->entry, types);
+            // the variables the procedure doesn't assign keep their types, and
+            // the call returns only if the end of the body can be reached
+            for (int i = 0; i <= var_num; i++) {
+                if (i == var_num || proc->assigned[i]) {
+                    types[i] = proc->exit[i];
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// infer the types after a statement list, updating the types before it
+static void infer_stmts(TreeNode *t, ValueType *types) {
+    for (; t != NULL && REACHED(types); t = t->sibling) {
+        infer_stmt(t, types);
+    }
+}
+
+// infer the types after a procedure body or the main program
+static void infer_body(TreeNode *t, ValueType *types) {
+    // a break or continue outside repeat ends the body, as in the evaluator
+    LoopTypes body = { new_types(), new_types() };
+    current_loop = &body;
+    infer_stmts(t, types);
+    join_types(types, body.breaks);
+    join_types(types, body.continues);
+    current_loop = NULL;
+    free(body.breaks);
+    free(body.continues);
+}
+
+// infer the types of a program, keeping the types of the variables
+static void infer(TreeNode *t) {
+    st_init(&var_table);
+    var_names = NULL;
+    var_num = 0;
+    var_capacity = 0;
+    st_init(&proc_table);
+
+    // collect procedure definitions
+    proc_num = 0;
+    for (TreeNode *p = t; p != NULL && p->node_type == PROC_NODE; p = p->sibling) {
+        proc_num += 1;
+    }
+    procs = (ProcTypes *)malloc((proc_num + 1) * sizeof(ProcTypes));
+    proc_num = 0;
+    for (; t != NULL && t->node_type == PROC_NODE; t = t->sibling) {
+        procs[proc_num].node = t;
+        proc_num += 1;
+        st_insert(&proc_table, t->child[0]->attr.name)->value = proc_num;
+    }
+    for (int i = 0; i < proc_num; i++) {
+        collect_vars(proc_body(procs[i].node));
+    }
+    collect_vars(t);
+
+    var_types = (ValueType *)calloc(var_num + 1, sizeof(ValueType));
+    for (int i = 0; i < proc_num; i++) {
+        procs[i].entry = new_types();
+        procs[i].exit = new_types();
+        procs[i].assigned = (char *)calloc(var_num + 1, 1);
+    }
+    int grew;
+    do {
+        grew = FALSE;
+        for (int i = 0; i < proc_num; i++) {
+            grew |= collect_assigned(proc_body(procs[i].node), procs[i].assigned);
+        }
+    } while (grew);
+
+    // walk the program until the types at the start and end of every
+    // procedure stop growing; variables start as integer 0
+    ValueType *types = new_types();
+    do {
+        procs_changed = FALSE;
+        for (int i = 0; i <= var_num; i++) {
+            types[i] = INT_TYPE;
+        }
+        infer_body(t, types);
+        for (int i = 0; i < proc_num; i++) {
+            if (REACHED(procs[i].entry)) {
+                memcpy(types, procs[i].entry, (var_num + 1) * sizeof(ValueType));
+                infer_body(proc_body(procs[i].node), types);
+                procs_changed |= join_types(procs[i].exit, types);
+            }
+        }
+    } while (procs_changed);
+    free(types);
+}
+
+// free what infer() keeps
+static void free_types(void) {
+    for (int i = 0; i < proc_num; i++) {
+        free(procs[i].entry);
+        free(procs[i].exit);
+        free(procs[i].assigned);
+    }
+    free(procs);
+    free(var_names);
+    free(var_types);
+    st_free(&var_table);
+    st_free(&proc_table);
+}
+
+// set the value_type of each expression in the program to the types its
+// value can have wherever it's evaluated (NO_TYPE if it's never reached),
+// following the types of the variables through the statements
+// (the tree must have passed analyze())
+void infer_types(TreeNode *t) {
+    infer(t);
+    free_types();
+}
+
+// the number of operations by the types of their operands
+static int int_op_num;
+static int float_op_num;
+static int mixed_op_num;
+static int unreached_op_num;
+
+// name of a type
+static const char* type_name(ValueType type) {
+    switch (type) {
+        case INT_TYPE: return "int";
+        case FLOAT_TYPE: return "float";
+        case MIXED_TYPE: return "mixed";
+        default: return "unreached";
+    }
+}
+
+// count the operations in a tree, and print the ones that need to check
+// the types of their operands
+static void count_ops(TreeNode *t) {
+    for (; t != NULL; t = t->sibling) {
+        if (t->node_type == EXPR_NODE && t->type.expr_type == OP_EXPR) {
+            ValueType left = t->child[0]->value_type;
+            ValueType right = t->child[1]->value_type;
+            if (t->value_type == NO_TYPE) {
+                unreached_op_num += 1;
+            }
+            else if (left == INT_TYPE && right == INT_TYPE) {
+                int_op_num += 1;
+            }
+            else if (left != MIXED_TYPE && right != MIXED_TYPE) {
+                float_op_num += 1;
+            }
+            else {
+                mixed_op_num += 1;
+                fprintf(result_file, "Mixed types at line %d, column %d -> Op: ",
+                        offset_line(t->span.start), offset_column(t->span.start));
+                print_token(t->attr.op, NULL);
+            }
+        }
+        for (int i = 0; i < MAX_CHILDREN; i++) {
+            count_ops(t->child[i]);
+        }
+    }
+}
+
+// infer the types, then print the type of each variable and how many
+// operations can skip the checks of their operand types
+void print_types(TreeNode *t) {
+    infer(t);
+    fprintf(result_file, "[========== Types ==========]\n");
+    for (int i = 0; i < var_num; i++) {
+        fprintf(result_file, "%s: %s\n", var_names[i], type_name(var_types[i]));
+    }
+    int_op_num = 0;
+    float_op_num = 0;
+    mixed_op_num = 0;
+    unreached_op_num = 0;
+    for (int i = 0; i < proc_num; i++) {
+        count_ops(proc_body(procs[i].node));
+    }
+    while (t != NULL && t->node_type == PROC_NODE) {
+        t = t->sibling;
+    }
+    count_ops(t);
+    int reached = int_op_num + float_op_num + mixed_op_num;
+    fprintf(result_file, "operations: %d, int: %d, float: %d, mixed: %d, unreached: %d\n",
+            reached + unreached_op_num, int_op_num, float_op_num, mixed_op_num,
+            unreached_op_num);
+    fprintf(result_file, "specialized: %d of %d (%.1f%%)\n", int_op_num + float_op_num,
+            reached, reached ? 100.0 * (int_op_num + float_op_num) / reached : 100.0);
+    free_types();
+}
\ No newline at end of file
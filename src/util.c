@@ -1,15 +1,47 @@
 #include "util.h"
+#include "global.h"
+#include "budget.h"
+#include "scanner.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 
-// copy a string
+// result file
+__thread FILE *result_file;
+
+// check if there's any syntax error
+int SYNTAX_ERROR = FALSE;
+
+// called with each error instead of printing it, if set
+void (*error_handler)(const char *kind, long offset, const char *message) = NULL;
+
+// copy a string (counted against the parse budget)
 char* copy_string(char *src) {
     if (src == NULL) {
         return NULL;
     }
     else {
-        char *target = (char *)malloc(strlen(src) + 1);
-        strcpy(target, src);
+        char *target = (char *)budget_malloc(strlen(src) + 1);
+        if (target != NULL) {
+            strcpy(target, src);
+        }
         return target;
     }
+}
+
+// report an error about an offset in source code, printed as e.g.
+// "Syntax error at line 3, column 7: Unexpected Token -> ;"
+void report_error(const char *kind, long offset, const char *format, ...) {
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    if (error_handler != NULL) {
+        error_handler(kind, offset, message);
+    }
+    else {
+        fprintf(result_file, "%s error at line %d, column %d: %s\n", kind,
+                offset_line(offset), offset_column(offset), message);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+#include "watch.h"
+#include "parser.h"
+#include "scanner.h"
+#include "tree.h"
+#include "analyze.h"
+#include "diff.h"
+#include "reader.h"
+#include "symtab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <dirent.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+// a source file in the watched directory
+typedef struct {
+    // name in the directory
+    char *name;
+    // tree of the last parse, NULL after a syntax error
+    TreeNode *ast;
+    // lines of the last parse
+    LineTable lines;
+    // hash of the tree
+    uint64_t hash;
+    // errors printed by the last parse and analysis
+    char *diagnostics;
+    size_t diagnostic_size;
+    // TRUE if the file has been printed and not deleted since
+    int exists;
+    // TRUE if the file has changed since it was last printed
+    int changed;
+} WatchedFile;
+
+// files seen in the directory, found by name through the table
+static WatchedFile *files = NULL;
+static int file_num = 0;
+static int file_capacity = 0;
+static SymTab file_names;
+
+// the directory being watched
+static const char *directory;
+// buffer the files are read into
+static SourceBuffer source = { NULL, NULL, 0, 0, 0 };
+
+// seconds from the first event of a change to the end of its output
+static double *latencies = NULL;
+static int latency_num = 0;
+static int latency_capacity = 0;
+
+// set by SIGINT and SIGTERM
+static volatile sig_atomic_t stopping = FALSE;
+
+// current time in seconds
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// stop watching at the next event
+static void stop_watching(int signal) {
+    (void)signal;
+    stopping = TRUE;
+}
+
+// check if a file name is a source file
+static int is_source(const char *name) {
+    size_t length = strlen(name);
+    return length > 4 && strcmp(name + length - 4, ".tny") == 0;
+}
+
+// mark a file as changed, adding it if it's new
+static void mark_changed(const char *name) {
+    Symbol *s = st_lookup(&file_names, name);
+    if (s == NULL) {
+        if (file_num == file_capacity) {
+            file_capacity = file_capacity ? file_capacity * 2 : 64;
+            files = (WatchedFile *)realloc(files, file_capacity * sizeof(WatchedFile));
+        }
+        WatchedFile *f = &files[file_num];
+        memset(f, 0, sizeof(WatchedFile));
+        f->name = strdup(name);
+        s = st_insert(&file_names, f->name);
+        s->value = file_num;
+        file_num += 1;
+    }
+    files[s->value].changed = TRUE;
+}
+
+// mark every source file in the directory as changed
+static void scan_directory(void) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (is_source(entry->d_name)) {
+            mark_changed(entry->d_name);
+        }
+    }
+    closedir(dir);
+}
+
+// read the queued events and mark the files they name as changed
+static void read_events(int fd) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        for (char *p = buffer; p < buffer + n;) {
+            struct inotify_event *event = (struct inotify_event *)p;
+            if (event->mask & IN_Q_OVERFLOW) {
+                // events were lost, so look at every file
+                scan_directory();
+            }
+            else if (event->mask & IN_IGNORED) {
+                // the directory is gone
+                stopping = TRUE;
+            }
+            else if (event->len > 0 && is_source(event->name)) {
+                mark_changed(event->name);
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+// parse a file again, and print it unless nothing changed
+static void update_file(WatchedFile *f, int threads) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", directory, f->name);
+    read_source(path, &source);
+    if (source.size < 0) {
+        // deleted, or replaced before it could be read
+        if (source.error != ENOENT) {
+            fprintf(stderr, "Can't read %s: %s\n", path, strerror(source.error));
+        }
+        if (f->exists) {
+            fprintf(result_file, "==> %s <==\nDeleted\n", f->name);
+        }
+        free_tree(f->ast);
+        free(f->lines.starts);
+        free(f->diagnostics);
+        f->ast = NULL;
+        f->lines = (LineTable){ NULL, 0, 0 };
+        f->diagnostics = NULL;
+        f->diagnostic_size = 0;
+        f->exists = FALSE;
+        return;
+    }
+
+    // parse and check, keeping the errors printed
+    FILE *saved_file = result_file;
+    char *diagnostics = NULL;
+    size_t diagnostic_size = 0;
+    FILE *capture = open_memstream(&diagnostics, &diagnostic_size);
+    if (capture != NULL) {
+        result_file = capture;
+    }
+    SYNTAX_ERROR = FALSE;
+    set_source(source.data, source.size);
+    TreeNode *ast = parse();
+    int error_num = 0;
+    uint64_t hash = 0;
+    if (SYNTAX_ERROR) {
+        free_tree(ast);
+        ast = NULL;
+    }
+    else {
+        hash = hash_tree(ast);
+        error_num = analyze(ast);
+    }
+    if (capture != NULL) {
+        fclose(capture);
+        result_file = saved_file;
+    }
+
+    // a save that doesn't change the tree, e.g. of a comment, prints nothing new
+    int same = f->exists && (ast == NULL) == (f->ast == NULL)
+               && (ast == NULL || hash == f->hash)
+               && diagnostic_size == f->diagnostic_size
+               && (diagnostic_size == 0 || memcmp(diagnostics, f->diagnostics, diagnostic_size) == 0);
+    fprintf(result_file, "==> %s <==\n", f->name);
+    if (same) {
+        fprintf(result_file, "No changes\n");
+    }
+    else {
+        if (diagnostic_size > 0) {
+            fwrite(diagnostics, 1, diagnostic_size, result_file);
+        }
+        if (ast != NULL && error_num == 0) {
+            fprintf(result_file, "[========== AST ==========]\n");
+            print_tree_parallel(ast, threads);
+        }
+    }
+
+    // keep the new tree and its lines
+    free_tree(f->ast);
+    free(f->lines.starts);
+    free(f->diagnostics);
+    f->ast = ast;
+    f->lines = line_table;
+    line_table = (LineTable){ NULL, 0, 0 };
+    f->hash = hash;
+    f->diagnostics = diagnostics;
+    f->diagnostic_size = diagnostic_size;
+    f->exists = TRUE;
+}
+
+// order files by name
+static int compare_files(const void *a, const void *b) {
+    return strcmp(files[*(const int *)a].name, files[*(const int *)b].name);
+}
+
+// parse and print the changed files in name order, and return how many
+static int update_changed(int threads) {
+    int *changed = (int *)malloc((file_num + 1) * sizeof(int));
+    int num = 0;
+    for (int i = 0; i < file_num; i++) {
+        if (files[i].changed) {
+            changed[num++] = i;
+            files[i].changed = FALSE;
+        }
+    }
+    qsort(changed, num, sizeof(int), compare_files);
+    for (int i = 0; i < num; i++) {
+        update_file(&files[changed[i]], threads);
+    }
+    fflush(result_file);
+    free(changed);
+    return num;
+}
+
+// order latencies
+static int compare_latencies(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// print the distribution of the latencies to stderr
+static void print_latencies(void) {
+    if (latency_num == 0) {
+        return;
+    }
+    qsort(latencies, latency_num, sizeof(double), compare_latencies);
+    double total = 0;
+    for (int i = 0; i < latency_num; i++) {
+        total += latencies[i];
+    }
+    fprintf(stderr, "updates: %d, latency min %.3f ms, mean %.3f ms, median %.3f ms, "
+            "p99 %.3f ms, max %.3f ms\n", latency_num, latencies[0] * 1e3,
+            total / latency_num * 1e3, latencies[latency_num / 2] * 1e3,
+            latencies[(int)(latency_num * 0.99)] * 1e3, latencies[latency_num - 1] * 1e3);
+}
+
+// print the AST of every .tny file in a directory, then watch it and print
+// the files again as they change, until interrupted
+int watch_directory(const char *dir, int debounce_millis, int threads) {
+    directory = dir;
+    // watch before the first scan, so no change is missed in between
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1 || inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO
+                                      | IN_MOVED_FROM | IN_DELETE) == -1) {
+        fprintf(stderr, "Can't watch %s: %s\n", dir, strerror(errno));
+        if (fd != -1) {
+            close(fd);
+        }
+        return FALSE;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_watching;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    st_init(&file_names);
+    scan_directory();
+    update_changed(threads);
+    fprintf(stderr, "Watching %s\n", dir);
+
+    int ok = TRUE;
+    while (!stopping) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        int ready = poll(&p, 1, -1);
+        if (ready < 0 && errno != EINTR) {
+            fprintf(stderr, "Can't wait for changes in %s: %s\n", dir, strerror(errno));
+            ok = FALSE;
+            break;
+        }
+        if (ready <= 0) {
+            // interrupted by a signal
+            continue;
+        }
+        double start = now();
+        read_events(fd);
+        // a burst of saves is one change: wait for the directory to be quiet
+        // (an error other than a signal is reported by the next wait above)
+        while (debounce_millis > 0 && !stopping) {
+            ready = poll(&p, 1, debounce_millis);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0) {
+                break;
+            }
+            read_events(fd);
+        }
+        int num = update_changed(threads);
+        if (num > 0) {
+            double latency = now() - start;
+            if (latency_num == latency_capacity) {
+                latency_capacity = latency_capacity ? latency_capacity * 2 : 256;
+                latencies = (double *)realloc(latencies, latency_capacity * sizeof(double));
+            }
+            latencies[latency_num++] = latency;
+            fprintf(stderr, "Updated %d file%s in %.3f ms\n", num, num > 1 ? "s" : "",
+                    latency * 1e3);
+        }
+    }
+    print_latencies();
+
+    close(fd);
+    for (int i = 0; i < file_num; i++) {
+        free_tree(files[i].ast);
+        free(files[i].lines.starts);
+        free(files[i].diagnostics);
+        free(files[i].name);
+    }
+    free(files);
+    st_free(&file_names);
+    free(source.data);
+    free(latencies);
+    return ok;
+}
\ No newline at end of file
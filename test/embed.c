@@ -0,0 +1,66 @@
+#include "tiny.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// print the AST of each file given through libtiny alone, the same
+// output as bin/tiny, so tools/test_lib.sh can compare the two
+
+// print a list of nodes and their children, indented by depth
+static void print_nodes(const TinyNode *node, int depth) {
+    for (; node != NULL; node = tiny_node_sibling(node)) {
+        char label[80];
+        tiny_node_label(node, label, sizeof(label));
+        printf("%*s%s\n", depth * 4, "", label);
+        for (int i = 0; i < 3; i++) {
+            print_nodes(tiny_node_child(node, i), depth + 1);
+        }
+    }
+}
+
+// read a whole file, or return NULL
+static char* read_file(const char *name, size_t *size) {
+    FILE *file = fopen(name, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    char *data = NULL;
+    *size = 0;
+    size_t capacity = 0;
+    size_t n;
+    do {
+        if (*size == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            data = (char *)realloc(data, capacity);
+        }
+        n = fread(data + *size, 1, capacity - *size, file);
+        *size += n;
+    } while (n > 0);
+    fclose(file);
+    return data;
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        size_t size;
+        char *data = read_file(argv[i], &size);
+        if (data == NULL) {
+            fprintf(stderr, "Can't read %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+        TinyOptions options = { .analyze = 1 };
+        TinyResult *result = tiny_parse_buffer(data, size, &options);
+        free(data);
+        int num;
+        const TinyDiagnostic *diagnostics = tiny_diagnostics(result, &num);
+        for (int j = 0; j < num; j++) {
+            printf("%s error at line %d, column %d: %s\n", diagnostics[j].kind,
+                   diagnostics[j].line, diagnostics[j].column, diagnostics[j].message);
+        }
+        if (num == 0 && tiny_ast(result) != NULL) {
+            printf("[========== AST ==========]\n");
+            print_nodes(tiny_ast(result), 0);
+        }
+        tiny_destroy(result);
+    }
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#!/bin/sh
+# Print a generated Tiny program to compare the parsers with --bench-parse:
+#   deep N   if and repeat statements nested N levels, around an
+#            expression in N parentheses (parse it with --max-depth=0)
+#   wide N   N top-level statements, each with a long flat expression
+
+usage() {
+    echo "usage: $0 deep|wide N" >&2
+    exit 1
+}
+
+[ $# -eq 2 ] || usage
+case $2 in
+    ''|*[!0-9]*) usage ;;
+esac
+
+case $1 in
+    deep)
+        awk -v n="$2" 'BEGIN {
+            print "x := 0;"
+            for (i = 0; i < n; i++) {
+                if (i % 2 == 0) {
+                    print "if x < " i " then"
+                }
+                else {
+                    print "repeat"
+                }
+            }
+            line = "x := "
+            for (i = 0; i < n; i++) {
+                line = line "("
+            }
+            line = line "x"
+            for (i = 0; i < n; i++) {
+                line = line " + " i ")"
+            }
+            print line ";"
+            for (i = n - 1; i >= 0; i--) {
+                if (i % 2 == 0) {
+                    print "end;"
+                }
+                else {
+                    print "until x = " i ";"
+                }
+            }
+            print "write x;"
+        }'
+        ;;
+    wide)
+        awk -v n="$2" 'BEGIN {
+            print "x := 0;"
+            for (i = 0; i < n; i++) {
+                if (i % 3 == 0) {
+                    print "if x < " i " then x := x + 1; else x := x - 1.5; end;"
+                }
+                else if (i % 3 == 1) {
+                    print "write x;"
+                }
+                else {
+                    line = "x := x"
+                    for (j = 0; j < 20; j++) {
+                        line = line (j % 4 == 0 ? " + " : j % 4 == 1 ? " * " : j % 4 == 2 ? " - " : " / ") (j + 1)
+                    }
+                    print line ";"
+                }
+            }
+        }'
+        ;;
+    *)
+        usage
+        ;;
+esac
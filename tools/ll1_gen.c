@@ -0,0 +1,154 @@
+// generate the predict table of the LL(1) parser from src/grammar.c
+// usage: ll1_gen > ll1_table.h
+#include "grammar.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// set of terminals, one bit each
+typedef uint64_t TerminalSet;
+
+// nonterminals that can derive nothing
+static int nullable[NT_NUM];
+// terminals that can start each nonterminal
+static TerminalSet first[NT_NUM];
+// terminals that can follow each nonterminal
+static TerminalSet follow[NT_NUM];
+// production for each nonterminal and lookahead, -1 for a syntax error
+static int predict[NT_NUM][TERMINAL_NUM];
+
+// check the kind of a symbol
+#define IS_TERMINAL(s) ((s) < NT_BASE)
+#define IS_NONTERMINAL(s) ((s) >= NT_BASE && (s) < ACTION_BASE)
+
+// first terminals of the symbols from rhs[i], and whether they can derive nothing
+static TerminalSet first_of(const short *rhs, int i, int *is_nullable) {
+    TerminalSet set = 0;
+    for (; rhs[i] != END_RHS; i++) {
+        int s = rhs[i];
+        if (IS_TERMINAL(s)) {
+            *is_nullable = 0;
+            return set | (1ULL << s);
+        }
+        else if (IS_NONTERMINAL(s)) {
+            set |= first[s - NT_BASE];
+            if (!nullable[s - NT_BASE]) {
+                *is_nullable = 0;
+                return set;
+            }
+        }
+        // actions derive nothing
+    }
+    *is_nullable = 1;
+    return set;
+}
+
+// compute nullable, first and follow sets up to a fixed point
+static void compute_sets(void) {
+    // like the recursive descent parser, the program ends wherever a statement
+    // list may end, and the parser reports any tokens left after it
+    follow[PROGRAM_NT] = (1ULL << ENDFILE_TOKEN) | (1ULL << END_TOKEN)
+                         | (1ULL << ELSE_TOKEN) | (1ULL << UNTIL_TOKEN);
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int p = 0; p < production_num; p++) {
+            const Production *prod = &productions[p];
+            int is_nullable;
+            TerminalSet set = first[prod->lhs] | first_of(prod->rhs, 0, &is_nullable);
+            if (set != first[prod->lhs] || (is_nullable && !nullable[prod->lhs])) {
+                first[prod->lhs] = set;
+                nullable[prod->lhs] |= is_nullable;
+                changed = 1;
+            }
+            for (int i = 0; prod->rhs[i] != END_RHS; i++) {
+                int s = prod->rhs[i];
+                if (!IS_NONTERMINAL(s)) {
+                    continue;
+                }
+                TerminalSet rest = first_of(prod->rhs, i + 1, &is_nullable);
+                if (is_nullable) {
+                    rest |= follow[prod->lhs];
+                }
+                if ((follow[s - NT_BASE] | rest) != follow[s - NT_BASE]) {
+                    follow[s - NT_BASE] |= rest;
+                    changed = 1;
+                }
+            }
+        }
+    }
+}
+
+// fill the predict table, or exit if the grammar is not LL(1)
+static void compute_predict(void) {
+    for (int n = 0; n < NT_NUM; n++) {
+        for (int t = 0; t < TERMINAL_NUM; t++) {
+            predict[n][t] = -1;
+        }
+    }
+    for (int p = 0; p < production_num; p++) {
+        const Production *prod = &productions[p];
+        int is_nullable;
+        TerminalSet set = first_of(prod->rhs, 0, &is_nullable);
+        if (is_nullable) {
+            set |= follow[prod->lhs];
+        }
+        for (int t = 0; t < TERMINAL_NUM; t++) {
+            if (!(set & (1ULL << t))) {
+                continue;
+            }
+            if (predict[prod->lhs][t] >= 0) {
+                fprintf(stderr, "ll1_gen: conflict on <%s> between productions %d and %d\n",
+                        nonterminal_names[prod->lhs], predict[prod->lhs][t], p);
+                exit(EXIT_FAILURE);
+            }
+            predict[prod->lhs][t] = p;
+        }
+    }
+}
+
+int main(void) {
+    if (production_num > 127) {
+        fprintf(stderr, "ll1_gen: too many productions\n");
+        return EXIT_FAILURE;
+    }
+    compute_sets();
+    compute_predict();
+    printf("// generated by tools/ll1_gen.c from src/grammar.c, do not edit\n");
+    printf("#ifndef _LL1_TABLE_H_\n#define _LL1_TABLE_H_\n\n");
+    printf("// production for each nonterminal and lookahead token, -1 for a syntax error\n");
+    printf("static const signed char predict_table[NT_NUM][TERMINAL_NUM] = {\n");
+    for (int n = 0; n < NT_NUM; n++) {
+        printf("    // <%s>\n    {", nonterminal_names[n]);
+        for (int t = 0; t < TERMINAL_NUM; t++) {
+            printf(" %d%s", predict[n][t], t + 1 < TERMINAL_NUM ? "," : " ");
+        }
+        printf("}%s\n", n + 1 < NT_NUM ? "," : "");
+    }
+    printf("};\n\n");
+    printf("// right-hand side of each production reversed, so it's pushed with one copy\n");
+    printf("static const short reversed_rhs[%d][MAX_RHS] = {\n", production_num);
+    for (int p = 0; p < production_num; p++) {
+        int length = 0;
+        while (productions[p].rhs[length] != END_RHS) {
+            length += 1;
+        }
+        printf("    {");
+        for (int i = length - 1; i >= 0; i--) {
+            printf(" %d%s", productions[p].rhs[i], i > 0 ? "," : " ");
+        }
+        printf("}%s\n", p + 1 < production_num ? "," : "");
+    }
+    printf("};\n\n");
+    printf("// length of the right-hand side of each production\n");
+    printf("static const unsigned char rhs_length[%d] = {", production_num);
+    for (int p = 0; p < production_num; p++) {
+        int length = 0;
+        while (productions[p].rhs[length] != END_RHS) {
+            length += 1;
+        }
+        printf("%s%d", p > 0 ? ", " : " ", length);
+    }
+    printf(" };\n\n#endif\n");
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#!/bin/sh
+# For each test program with an input file (test/NAME.in), translate it to C
+# with --emit-c, build it, run it on the input, and compare its output with
+# the reference evaluator's (--run). Exits with an error if any differs.
+
+tiny=${TINY:-bin/tiny}
+cc=${CC:-cc}
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+failed=0
+for input in test/*.in; do
+    program=${input%.in}.tny
+    name=$(basename "$program" .tny)
+    if ! "$tiny" --emit-c "$program" > "$dir/$name.c" \
+        || ! "$cc" -O2 -o "$dir/$name" "$dir/$name.c"; then
+        echo "FAIL $name: can't build the C translation"
+        failed=1
+        continue
+    fi
+    "$tiny" --run "$program" < "$input" > "$dir/$name.expected"
+    "$dir/$name" < "$input" > "$dir/$name.out"
+    if cmp -s "$dir/$name.expected" "$dir/$name.out"; then
+        echo "PASS $name"
+    else
+        echo "FAIL $name: output differs from --run"
+        diff "$dir/$name.expected" "$dir/$name.out" | head -10
+        failed=1
+    fi
+done
+exit $failed
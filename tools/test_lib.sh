@@ -0,0 +1,34 @@
+#!/bin/sh
+# Check that lib/libtiny.so exports only the tiny_* functions, and that
+# build/embed, which parses through libtiny alone, prints the same as
+# bin/tiny for each test program. Exits with an error if either fails.
+
+tiny=${TINY:-bin/tiny}
+embed=${EMBED:-build/embed}
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+failed=0
+nm -D --defined-only lib/libtiny.so | awk '{ print $3 }' \
+    | grep -v '^tiny_' > "$dir/exports"
+if [ -s "$dir/exports" ]; then
+    echo "FAIL libtiny.so exports more than tiny_*:"
+    head -10 "$dir/exports"
+    failed=1
+else
+    echo "PASS libtiny.so exports"
+fi
+
+for program in test/*.tny; do
+    name=$(basename "$program" .tny)
+    "$tiny" "$program" > "$dir/$name.expected"
+    LD_LIBRARY_PATH=lib "$embed" "$program" > "$dir/$name.out"
+    if cmp -s "$dir/$name.expected" "$dir/$name.out"; then
+        echo "PASS embed $name"
+    else
+        echo "FAIL embed $name: output differs from $tiny"
+        diff "$dir/$name.expected" "$dir/$name.out" | head -10
+        failed=1
+    fi
+done
+exit $failed